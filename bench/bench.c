@@ -0,0 +1,857 @@
+//
+// smbench: drives src/sm_watchapp.c on the host through the fake Pebble SDK
+// and reports per-operation cost for the status screen's hot paths.
+//
+// usage: smbench [iterations]
+//
+
+#include <stdlib.h>
+#include <time.h>
+#include "fake.h"
+#include "globals.h"
+#include "sm_watchapp.h"
+#include "phone.h"
+#include "link.h"
+#include "carousel.h"
+#include "bmp_stream.h"
+#include "canvas.h"
+#include "sparkline.h"
+#include "marquee.h"
+#include "debug_stats.h"
+#include "trace.h"
+#include "render.h"
+#include "governor.h"
+#include "refresh.h"
+#include "outbox.h"
+
+#undef time
+
+int pebble_app_main(void);
+
+static int iterations = 20000;
+
+static uint64_t host_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+
+typedef struct {
+	const char *name;
+	int ops;
+	uint64_t handler_ns;
+	uint64_t render_ns;
+	uint32_t suppressed;
+	FakeStats stats;
+} Result;
+
+//scenario checks print "ok" or "WRONG"; any WRONG makes smbench exit 1
+static int failed_checks;
+
+static const char *check(bool ok) {
+	if (!ok)
+		failed_checks++;
+	return ok ? "ok" : "WRONG";
+}
+
+static void report_header(void) {
+	printf("%-18s %8s %10s %10s %9s %9s %9s %9s %9s %8s %8s %8s\n",
+	       "scenario", "ops", "ns/op", "render ns", "allocs/op", "frames/op", "draws/op", "glyphs/op", "skips/op", "msgs out", "B in/op", "B out/op");
+}
+
+static void report(const Result *r) {
+	double n = r->ops;
+	printf("%-18s %8d %10.1f %10.1f %9.2f %9.2f %9.2f %9.1f %9.2f %8u %8.1f %8.1f\n",
+	       r->name, r->ops, r->handler_ns / n, r->render_ns / n,
+	       r->stats.allocs / n, r->stats.frames / n, r->stats.layer_draws / n, r->stats.glyphs / n,
+	       r->suppressed / n, r->stats.msgs_out, r->stats.bytes_in / n, r->stats.bytes_out / n);
+}
+
+static void bench_status(const char *name, bool changing) {
+	uint8_t buffers[2][512];
+	uint16_t sizes[2];
+	Result r = {name, iterations, 0, 0};
+	uint32_t suppressed = sm_suppressed_updates();
+
+	sizes[0] = phone_build_status(buffers[0], sizeof(buffers[0]), 0);
+	sizes[1] = phone_build_status(buffers[1], sizeof(buffers[1]), 1);
+
+	fake_stats_reset();
+	for (int i = 0; i < iterations; i++) {
+		int v = changing ? (i & 1) : 0;
+		fake_advance_ms(RENDER_FRAME_MS);		//messages a frame apart, each gets its own
+		uint64_t t0 = host_ns();
+		fake_deliver(buffers[v], sizes[v]);
+		uint64_t t1 = host_ns();
+		fake_render();
+		uint64_t t2 = host_ns();
+		r.handler_ns += t1 - t0;
+		r.render_ns += t2 - t1;
+	}
+	r.suppressed = sm_suppressed_updates() - suppressed;
+	r.stats = fake_stats;
+	report(&r);
+}
+
+static void bench_minute_tick(void) {
+	Result r = {"minute tick", iterations, 0, 0};
+
+	fake_stats_reset();
+	for (int i = 0; i < iterations; i++) {
+		uint64_t t0 = host_ns();
+		fake_advance_ms(60 * 1000);
+		r.handler_ns += host_ns() - t0;
+	}
+	r.stats = fake_stats;
+	report(&r);
+}
+
+//a resync that arrives as one message per section, 40 ms apart
+static void bench_resync_burst(void) {
+	uint8_t buffers[2][SM_NUM_SECTIONS][256];
+	uint16_t sizes[2][SM_NUM_SECTIONS];
+	Result r = {"resync burst", iterations / 10 > 0 ? iterations / 10 : 1, 0, 0};
+	RenderStats before = *render_get_stats();
+
+	for (int v = 0; v < 2; v++)
+		for (int s = 0; s < SM_NUM_SECTIONS; s++)
+			sizes[v][s] = phone_build_section(buffers[v][s], sizeof(buffers[v][s]), s, v);
+
+	fake_stats_reset();
+	for (int i = 0; i < r.ops; i++) {
+		fake_advance_ms(1000);
+		for (int s = 0; s < SM_NUM_SECTIONS; s++) {
+			uint64_t t0 = host_ns();
+			fake_deliver(buffers[i & 1][s], sizes[i & 1][s]);
+			r.handler_ns += host_ns() - t0;
+			fake_render();
+			fake_advance_ms(40);
+		}
+	}
+	fake_advance_ms(1000);
+	r.stats = fake_stats;
+	report(&r);
+	printf("%-18s %u frames for %u handler runs, %u saved, %u changes skipped\n", "",
+	       render_get_stats()->frames - before.frames, render_get_stats()->requests - before.requests,
+	       render_get_stats()->saved - before.saved, render_get_stats()->skipped - before.skipped);
+}
+
+//a section that changes on the phone while another one is polled must still
+//be sent when its own poll comes. the weather reply lists the calendar's new
+//generation too, the watch must not take it without the calendar's tuples.
+static void bench_poll_generations(void) {
+	Result r = {"poll generations", iterations / 100 > 0 ? iterations / 100 : 1, 0, 0};
+	uint32_t sent = 0, skipped = 0;
+
+	phone_attach(40);
+	fake_click(BUTTON_ID_UP);
+	fake_advance_ms(1000);
+
+	fake_stats_reset();
+	for (int i = 0; i < r.ops; i++) {
+		phone_change_section(SM_SECTION_CALENDAR);
+
+		uint64_t t0 = host_ns();
+		sendCommand(SM_STATUS_UPD_WEATHER_KEY);
+		fake_advance_ms(1000);
+
+		PhoneStats before = phone_stats;
+		sendCommand(SM_STATUS_UPD_CAL_KEY);
+		fake_advance_ms(1000);
+		r.handler_ns += host_ns() - t0;
+		sent += phone_stats.sections_sent - before.sections_sent;
+		skipped += phone_stats.sections_skipped - before.sections_skipped;
+	}
+	r.stats = fake_stats;
+	phone_detach();
+	report(&r);
+	printf("%-18s calendar polls: %u sections sent, %u skipped, %s\n", "", sent, skipped,
+	       check(sent == (uint32_t)r.ops && skipped == 0));
+}
+
+//each fresh weather reply arrives a second time and is followed by one a
+//generation older, like retransmits and late replies on a flaky link
+static void bench_out_of_order(void) {
+	uint8_t fresh[256], old[256];
+	Result r = {"out of order", iterations / 10 > 0 ? iterations / 10 : 1, 0, 0};
+	SequenceStats before = *sm_sequence_stats();
+	uint32_t duplicate, stale;
+
+	fake_stats_reset();
+	for (int i = 0; i < r.ops; i++) {
+		phone_change_section(SM_SECTION_WEATHER);
+		uint16_t fresh_size = phone_build_reply(fresh, sizeof(fresh), SM_SECTION_WEATHER, 0);
+		uint16_t old_size = phone_build_reply(old, sizeof(old), SM_SECTION_WEATHER, 1);
+
+		fake_advance_ms(RENDER_FRAME_MS);
+		fake_deliver(fresh, fresh_size);
+		fake_advance_ms(RENDER_FRAME_MS);
+		uint64_t t0 = host_ns();
+		fake_deliver(fresh, fresh_size);
+		fake_deliver(old, old_size);
+		r.handler_ns += host_ns() - t0;
+	}
+	fake_advance_ms(RENDER_FRAME_MS);
+	r.stats = fake_stats;
+	report(&r);
+	duplicate = sm_sequence_stats()->duplicate - before.duplicate;
+	stale = sm_sequence_stats()->stale - before.stale;
+	printf("%-18s %u duplicate, %u stale sections dropped, %s\n", "", duplicate, stale,
+	       check(duplicate == (uint32_t)r.ops && stale == (uint32_t)r.ops));
+}
+
+//the phone app restarts and numbers its sections from 1 again while the watch
+//holds calendar generation 5; the first calendar poll has to be taken, and
+//then the watch echoes generation 1 so the next poll needs nothing
+static void bench_phone_restart(void) {
+	SequenceStats before = *sm_sequence_stats();
+	PhoneStats first, second;
+
+	phone_attach(40);
+	phone_restart();
+	fake_click(BUTTON_ID_UP);
+	fake_advance_ms(1000);
+	for (int i = 0; i < 4; i++)
+		phone_change_section(SM_SECTION_CALENDAR);
+	sendCommand(SM_STATUS_UPD_CAL_KEY);
+	fake_advance_ms(1000);
+
+	phone_restart();
+	first = phone_stats;
+	sendCommand(SM_STATUS_UPD_CAL_KEY);
+	fake_advance_ms(1000);
+	second = phone_stats;
+	sendCommand(SM_STATUS_UPD_CAL_KEY);
+	fake_advance_ms(1000);
+	phone_detach();
+
+	printf("%-18s %u restarts, %u stale; first poll %u sent, next poll %u sent %u skipped, %s\n", "phone restart",
+	       sm_sequence_stats()->restarts - before.restarts, sm_sequence_stats()->stale - before.stale,
+	       second.sections_sent - first.sections_sent, phone_stats.sections_sent - second.sections_sent,
+	       phone_stats.sections_skipped - second.sections_skipped,
+	       check(sm_sequence_stats()->restarts - before.restarts == 2 && sm_sequence_stats()->stale == before.stale
+	             && second.sections_sent - first.sections_sent == 1 && phone_stats.sections_sent == second.sections_sent
+	             && phone_stats.sections_skipped - second.sections_skipped == 1));
+}
+
+//watch battery draining one percent per event, the gauge only moves every ~6%
+static void bench_battery(void) {
+	Result r = {"battery drain", iterations, 0, 0};
+
+	fake_stats_reset();
+	for (int i = 0; i < iterations; i++) {
+		BatteryChargeState state = {(uint8_t)(100 - i % 101), false, false};
+
+		fake_advance_ms(RENDER_FRAME_MS);
+		uint64_t t0 = host_ns();
+		fake_set_battery(state);
+		r.handler_ns += host_ns() - t0;
+	}
+	r.stats = fake_stats;
+	report(&r);
+
+	//back to the stand-in's default, a low battery would slow the later scenarios down
+	fake_set_battery((BatteryChargeState){80, false, false});
+}
+
+//the link drops and comes back five times a second apart, then stays up
+static void bench_link_flap(void) {
+	Result r = {"link flap", iterations / 100 > 0 ? iterations / 100 : 1, 0, 0};
+
+	phone_attach(40);
+	fake_stats_reset();
+	for (int i = 0; i < r.ops; i++) {
+		uint64_t t0 = host_ns();
+		for (int flap = 0; flap < 5; flap++) {
+			fake_set_bluetooth(false);
+			fake_advance_ms(500);
+			fake_set_bluetooth(true);
+			fake_advance_ms(1000);
+		}
+		fake_advance_ms(120 * 1000);
+		r.handler_ns += host_ns() - t0;
+	}
+	r.stats = fake_stats;
+	phone_detach();
+	report(&r);
+}
+
+//fills the forecast, reminders and nav panels, then steps through all five
+//with bursts of three DOWN presses 30 ms apart
+static void bench_carousel(void) {
+	Result r = {"panel scroll", iterations / 10 > 0 ? iterations / 10 : 1, 0, 0};
+	uint8_t buffer[256];
+	DictionaryIterator iter;
+
+	dict_write_begin(&iter, buffer, sizeof(buffer));
+	dict_write_cstring(&iter, SM_WEATHER_DAY1_KEY, "Tue");
+	dict_write_cstring(&iter, SM_WEATHER_DAY2_KEY, "Wed");
+	dict_write_cstring(&iter, SM_WEATHER_DAY3_KEY, "Thu");
+	dict_write_uint8(&iter, SM_WEATHER_ICON1_KEY, 0);
+	dict_write_uint8(&iter, SM_WEATHER_ICON2_KEY, 3);
+	dict_write_uint8(&iter, SM_WEATHER_ICON3_KEY, 1);
+	dict_write_cstring(&iter, SM_REMINDERS_KEY, "Pick up parcel");
+	dict_write_cstring(&iter, SM_NAV_INSTRUCTIONS_KEY, "Turn left onto Main St");
+	fake_deliver(buffer, (uint16_t)dict_write_end(&iter));
+
+	fake_stats_reset();
+	for (int i = 0; i < r.ops; i++) {
+		uint64_t t0 = host_ns();
+		for (int press = 0; press < 3; press++) {
+			fake_click(BUTTON_ID_DOWN);
+			fake_advance_ms(30);
+		}
+		fake_advance_ms(1000);
+		r.handler_ns += host_ns() - t0;
+	}
+	r.stats = fake_stats;
+	report(&r);
+}
+
+//compares the streamed bitmap with the phone's image, clipped to the bitmap
+static bool bitmap_matches(int width, int height) {
+	GBitmap *bmp = bmp_stream_bitmap();
+	int rows = height < bmp->bounds.size.h ? height : bmp->bounds.size.h;
+	int cols = (width < bmp->bounds.size.w ? width : bmp->bounds.size.w) / 8;
+
+	for (int r = 0; r < rows; r++)
+		for (int c = 0; c < cols; c++)
+			if (((uint8_t *)bmp->addr)[r * bmp->row_size_bytes + c] != phone_bitmap_byte(width, r, c))
+				return false;
+	return true;
+}
+
+//streams a slot sized image raw and RLE, then a full screen one that is clipped;
+//heap must not grow after the first image
+static void bench_bitmap_stream(void) {
+	static const struct {const char *name; int w, h, encoding;} cases[] = {
+		{"stream 144x45 raw", 144, 45, BMP_RAW},
+		{"stream 144x45 rle", 144, 45, BMP_RLE},
+		{"stream 144x168 rle", 144, 168, BMP_RLE},
+	};
+
+	for (size_t k = 0; k < sizeof(cases) / sizeof(cases[0]); k++) {
+		Result r = {cases[k].name, iterations / 100 > 0 ? iterations / 100 : 1, 0, 0};
+		bool ok = true;
+		int chunks = 0;
+
+		fake_stats_reset();
+		for (int i = 0; i < r.ops; i++) {
+			uint64_t t0 = host_ns();
+			chunks = phone_send_bitmap(cases[k].w, cases[k].h, cases[k].encoding, 20);
+			r.handler_ns += host_ns() - t0;
+			ok = ok && bitmap_matches(cases[k].w, cases[k].h);
+		}
+		r.stats = fake_stats;
+		report(&r);
+		printf("%-18s %d chunks/image, decoded %s, heap peak %zu B\n", "", chunks, check(ok), fake_stats.heap_peak);
+	}
+}
+
+static void show_panel(int panel) {
+	for (int i = 0; i < 16 && carousel_active() != panel; i++) {
+		fake_click(BUTTON_ID_DOWN);
+		fake_advance_ms(400);
+	}
+}
+
+//music panel on screen, each new song title is too long for it and scrolls
+//its passes out before the next one arrives
+static void bench_marquee(void) {
+	static const char *titles[] = {"Everything In Its Right Place (Live in Paris)", "An Ending (Ascent) - Remastered 2019"};
+	Result r = {"marquee title", 10, 0, 0};
+	uint8_t buffer[128];
+	DictionaryIterator iter;
+	MarqueeStats before;
+	uint32_t measures, passes;
+
+	show_panel(1);
+	before = *marquee_get_stats();
+	fake_stats_reset();
+	for (int i = 0; i < r.ops; i++) {
+		dict_write_begin(&iter, buffer, sizeof(buffer));
+		dict_write_cstring(&iter, SM_STATUS_MUS_TITLE_KEY, titles[i & 1]);
+		uint16_t size = (uint16_t)dict_write_end(&iter);
+
+		uint64_t t0 = host_ns();
+		fake_deliver(buffer, size);
+		r.handler_ns += host_ns() - t0;
+		fake_advance_ms(60000);
+	}
+	r.stats = fake_stats;
+	report(&r);
+	measures = marquee_get_stats()->measures - before.measures;
+	passes = marquee_get_stats()->passes - before.passes;
+	printf("%-18s %u measures, %u steps, %u passes, %s\n", "", measures,
+	       marquee_get_stats()->steps - before.steps, passes,
+	       check(measures == (uint32_t)r.ops && passes == (uint32_t)r.ops * MARQUEE_PASSES));
+
+	show_panel(0);
+}
+
+//the calendar panel rebuilt as a command list: a rule, an icon and two texts
+static uint16_t canvas_list(uint8_t *buffer, uint16_t size, int variant) {
+	static const char *titles[] = {"Design review", "Dentist"};
+	uint8_t list[128];
+	size_t n = 0;
+	DictionaryIterator iter;
+
+	list[n++] = CANVAS_LINE; list[n++] = 6; list[n++] = 0; list[n++] = 138; list[n++] = 0; list[n++] = CANVAS_WHITE;
+	list[n++] = CANVAS_BITMAP; list[n++] = 100; list[n++] = 3; list[n++] = (uint8_t)variant;
+	list[n++] = CANVAS_TEXT; list[n++] = 6; list[n++] = 0; list[n++] = 90; list[n++] = 21; list[n++] = CANVAS_WHITE; list[n++] = 2; list[n++] = 0;
+	list[n++] = CANVAS_TEXT; list[n++] = 6; list[n++] = 15; list[n++] = 132; list[n++] = 28; list[n++] = CANVAS_WHITE; list[n++] = 4; list[n++] = 1;
+	list[n++] = CANVAS_END;
+	n += (size_t)sprintf((char *)&list[n], "Today 14:30") + 1;
+	n += (size_t)sprintf((char *)&list[n], "%s", titles[variant & 1]) + 1;
+
+	dict_write_begin(&iter, buffer, size);
+	dict_write_data(&iter, SM_CANVAS_DICT_KEY, list, n);
+	return (uint16_t)dict_write_end(&iter);
+}
+
+//canvas panel on screen: a new list every tenth message, the same one otherwise
+static void bench_canvas(void) {
+	uint8_t buffers[2][256];
+	uint16_t sizes[2];
+	Result r = {"canvas panel", iterations, 0, 0};
+	uint32_t parses;
+
+	sizes[0] = canvas_list(buffers[0], sizeof(buffers[0]), 0);
+	sizes[1] = canvas_list(buffers[1], sizeof(buffers[1]), 1);
+	fake_deliver(buffers[0], sizes[0]);
+	show_panel(6);
+
+	parses = canvas_get_stats()->parses;
+	fake_stats_reset();
+	for (int i = 0; i < iterations; i++) {
+		int v = (i / 10) & 1;
+		fake_advance_ms(RENDER_FRAME_MS);
+		uint64_t t0 = host_ns();
+		fake_deliver(buffers[v], sizes[v]);
+		uint64_t t1 = host_ns();
+		fake_invalidate();
+		fake_render();
+		r.handler_ns += t1 - t0;
+		r.render_ns += host_ns() - t1;
+	}
+	r.stats = fake_stats;
+	report(&r);
+	printf("%-18s %u parses for %d lists\n", "", canvas_get_stats()->parses - parses, iterations);
+
+	show_panel(0);
+}
+
+//bitcoin graph on screen, the phone appends one price a message all day
+static void bench_graph(void) {
+	Result r = {"graph append", iterations, 0, 0};
+	uint8_t buffer[128], series[48];
+	DictionaryIterator iter;
+	SparklineStats before;
+
+	series[0] = SPARKLINE_RESET;
+	series[1] = 128;
+	for (int i = 2; i < (int)sizeof(series); i++)
+		series[i] = (uint8_t)(i % 7 - 3);
+	dict_write_begin(&iter, buffer, sizeof(buffer));
+	dict_write_cstring(&iter, SM_BITCOIN_TITLE_KEY, "BTC/USD");
+	dict_write_cstring(&iter, SM_BITCOIN_CURR_KEY, "67,310");
+	dict_write_cstring(&iter, SM_BITCOIN_HIGH_KEY, "68,020");
+	dict_write_cstring(&iter, SM_BITCOIN_LOW_KEY, "66,480");
+	dict_write_data(&iter, SM_BITCOIN_GRAPH_KEY, series, sizeof(series));
+	fake_deliver(buffer, (uint16_t)dict_write_end(&iter));
+	show_panel(7);
+	fake_render();
+
+	before = *sparkline_get_stats();
+	fake_stats_reset();
+	for (int i = 0; i < iterations; i++) {
+		uint8_t append[2] = {0, (uint8_t)((i * 5) % 9 - 4)};
+		fake_advance_ms(RENDER_FRAME_MS);
+		uint64_t t0 = host_ns();
+		dict_write_begin(&iter, buffer, sizeof(buffer));
+		dict_write_data(&iter, SM_BITCOIN_GRAPH_KEY, append, sizeof(append));
+		fake_deliver(buffer, (uint16_t)dict_write_end(&iter));
+		uint64_t t1 = host_ns();
+		fake_render();
+		r.handler_ns += t1 - t0;
+		r.render_ns += host_ns() - t1;
+	}
+	r.stats = fake_stats;
+	report(&r);
+	printf("%-18s %.2f segments/op, %u full redraws\n", "",
+	       (double)(sparkline_get_stats()->segments - before.segments) / iterations,
+	       sparkline_get_stats()->redraws - before.redraws);
+
+	show_panel(0);
+}
+
+//an hour on screen with the phone answering every poll
+static FakeStats idle_stats;
+static int idle_hours;
+
+static void bench_idle_hour(void) {
+	Result r = {"idle hour", iterations / 1000 > 0 ? iterations / 1000 : 1, 0, 0};
+
+	//UP refresh so the phone hands out fresh poll intervals
+	phone_attach(40);
+	fake_click(BUTTON_ID_UP);
+	fake_advance_ms(1000);
+
+	fake_stats_reset();
+	for (int i = 0; i < r.ops; i++) {
+		uint64_t t0 = host_ns();
+		fake_advance_ms(60 * 60 * 1000);
+		r.handler_ns += host_ns() - t0;
+	}
+	r.stats = fake_stats;
+	phone_detach();
+	report(&r);
+
+	idle_stats = fake_stats;
+	idle_hours = r.ops;
+}
+
+//an idle hour at each battery and link state, with the governor's policy
+//checked for each
+static void bench_governor(void) {
+	static const struct {
+		const char *name;
+		BatteryChargeState battery;
+		bool connected;
+		GovernorPolicy policy;
+	} cases[] = {
+		{"80%",				{80, false, false},	true,	{GOVERNOR_FULL, 1, true}},
+		{"10%",				{10, false, false},	true,	{GOVERNOR_SAVING, GOVERNOR_LOW_SCALE, false}},
+		{"10% charging",	{10, true, true},	true,	{GOVERNOR_FULL, 1, true}},
+		{"disconnected",	{80, false, false},	false,	{GOVERNOR_PAUSED, 0, true}},
+	};
+	enum {NUM_CASES = sizeof(cases) / sizeof(cases[0])};
+	Result r = {"governor hour", NUM_CASES, 0, 0};
+	uint32_t polls[NUM_CASES];
+	GovernorPolicy seen[NUM_CASES];
+
+	phone_attach(40);
+	fake_stats_reset();
+	for (int i = 0; i < NUM_CASES; i++) {
+		fake_set_battery(cases[i].battery);
+		fake_set_bluetooth(cases[i].connected);
+		if (cases[i].connected) {
+			//UP refresh so the phone hands out fresh poll intervals
+			fake_click(BUTTON_ID_UP);
+			fake_advance_ms(1000);
+		}
+		seen[i] = *governor_get_policy();
+
+		uint32_t before = refresh_get_stats()->polls;
+		uint64_t t0 = host_ns();
+		fake_advance_ms(60 * 60 * 1000);
+		r.handler_ns += host_ns() - t0;
+		polls[i] = refresh_get_stats()->polls - before;
+	}
+	r.stats = fake_stats;
+	report(&r);
+
+	for (int i = 0; i < NUM_CASES; i++) {
+		bool ok = seen[i].mode == cases[i].policy.mode && seen[i].poll_scale == cases[i].policy.poll_scale
+			&& seen[i].animate == cases[i].policy.animate;
+		printf("%-18s %-13s %3u polls, scale %u, animations %-3s %s\n", "", cases[i].name, polls[i],
+		       seen[i].poll_scale, seen[i].animate ? "on" : "off", check(ok));
+	}
+
+	//back to a live link on a full battery
+	fake_set_battery((BatteryChargeState){80, false, false});
+	fake_set_bluetooth(true);
+	fake_advance_ms(60 * 1000);
+	phone_detach();
+}
+
+//a notification covers the screen for half an hour, long enough for every
+//poll to fall due; showing it again should send one catch-up message
+static void bench_covered(void) {
+	Result r = {"covered 30 min", iterations / 1000 > 0 ? iterations / 1000 : 1, 0, 0};
+	uint32_t covered_msgs = 0, covered_wakeups = 0, resume_msgs = 0, catchups = 0, answered = 0;
+
+	phone_attach(40);
+	fake_stats_reset();
+	for (int i = 0; i < r.ops; i++) {
+		fake_click(BUTTON_ID_UP);
+		fake_advance_ms(1000);
+
+		FakeStats before = fake_stats;
+		fake_set_window_covered(true);
+		fake_advance_ms(30 * 60 * 1000);
+		covered_msgs += fake_stats.msgs_out - before.msgs_out;
+		covered_wakeups += fake_stats.timer_wakeups - before.timer_wakeups;
+
+		before = fake_stats;
+		uint32_t polls = refresh_get_stats()->catchups, requests = phone_stats.requests;
+		uint64_t t0 = host_ns();
+		fake_set_window_covered(false);
+		r.handler_ns += host_ns() - t0;
+		fake_advance_ms(1000);
+		resume_msgs += fake_stats.msgs_out - before.msgs_out;
+		catchups += refresh_get_stats()->catchups - polls;
+		answered += phone_stats.requests - requests;
+	}
+	r.stats = fake_stats;
+
+	//a short cover: music falls due inside the slack window right after, but
+	//not while covered, so showing the screen again sends nothing
+	fake_click(BUTTON_ID_UP);
+	fake_advance_ms(1000);
+	fake_set_window_covered(true);
+	fake_advance_ms(150 * 1000);
+	FakeStats before = fake_stats;
+	uint32_t polls = refresh_get_stats()->catchups;
+	fake_set_window_covered(false);
+	fake_advance_ms(1000);
+	uint32_t short_msgs = fake_stats.msgs_out - before.msgs_out, short_polls = refresh_get_stats()->catchups - polls;
+	fake_advance_ms(120 * 1000);
+
+	phone_detach();
+	report(&r);
+	printf("%-18s covered: %u messages, %u timer wakeups; shown: %u messages, %u polls; short cover: %u messages, %s\n", "",
+	       covered_msgs, covered_wakeups, resume_msgs, catchups, short_msgs + short_polls,
+	       check(covered_msgs == 0 && covered_wakeups == 0 && resume_msgs == (uint32_t)r.ops
+	             && answered == (uint32_t)r.ops && catchups == (uint32_t)r.ops * 3
+	             && short_msgs == 0 && short_polls == 0));
+}
+
+//everything on the status screen changes while it is covered; none of it may
+//reach the layers before the window is shown again
+static void bench_covered_burst(void) {
+	static const char *days[] = {"Mon", "Tue", "Wed"};
+	static const uint32_t graph_keys[] = {
+		SM_BITCOIN_TITLE_KEY, SM_BITCOIN_CURR_KEY, SM_BITCOIN_HIGH_KEY, SM_BITCOIN_LOW_KEY,
+		SM_STOCKS_TITLE_KEY, SM_STOCKS_CURR_KEY, SM_STOCKS_HIGH_KEY, SM_STOCKS_LOW_KEY
+	};
+	uint8_t buffer[SM_INBOX_SIZE], series[2] = {SPARKLINE_RESET, 128};
+	DictionaryIterator iter;
+	char label[16];
+	uint32_t covered_frames = 0, covered_sets = 0, shown_frames = 0;
+
+	fake_advance_ms(1000);
+	for (int i = 0; i < 4; i++) {
+		FakeStats before = fake_stats;
+		uint32_t frames = render_get_stats()->frames;
+		fake_set_window_covered(true);
+
+		fake_deliver(buffer, phone_build_status(buffer, sizeof(buffer), i + 1));
+		dict_write_begin(&iter, buffer, sizeof(buffer));
+		for (int d = 0; d < 3; d++) {
+			dict_write_cstring(&iter, SM_WEATHER_DAY1_KEY + d, days[(d + i) % 3]);
+			dict_write_int32(&iter, SM_WEATHER_ICON1_KEY + d, (d + i) % 4);
+		}
+		for (int k = 0; k < (int)(sizeof(graph_keys) / sizeof(graph_keys[0])); k++) {
+			snprintf(label, sizeof(label), "%d", 100 * i + k);
+			dict_write_cstring(&iter, graph_keys[k], label);
+		}
+		dict_write_data(&iter, SM_BITCOIN_GRAPH_KEY, series, sizeof(series));
+		dict_write_data(&iter, SM_STOCKS_GRAPH_KEY, series, sizeof(series));
+		fake_deliver(buffer, (uint16_t)dict_write_end(&iter));
+		fake_advance_ms(1000);
+		covered_frames += render_get_stats()->frames - frames;
+		covered_sets += fake_stats.text_sets - before.text_sets;
+
+		frames = render_get_stats()->frames;
+		fake_set_window_covered(false);
+		shown_frames += render_get_stats()->frames - frames;
+		fake_advance_ms(1000);
+	}
+	printf("%-18s covered: %u frames, %u text sets; shown: %u frames, %s\n", "covered burst",
+	       covered_frames, covered_sets, shown_frames,
+	       check(covered_frames == 0 && covered_sets == 0 && shown_frames == 4));
+}
+
+static void bench_full_redraw(void) {
+	Result r = {"full redraw", iterations, 0, 0};
+
+	fake_stats_reset();
+	for (int i = 0; i < iterations; i++) {
+		fake_invalidate();
+		uint64_t t0 = host_ns();
+		fake_render();
+		r.render_ns += host_ns() - t0;
+	}
+	r.stats = fake_stats;
+	report(&r);
+}
+
+//UP refreshes everything; the phone changes the music section every tenth press
+static void bench_refresh(void) {
+	Result r = {"refresh (UP)", iterations, 0, 0};
+	uint32_t suppressed = sm_suppressed_updates();
+
+	phone_attach(40);
+	fake_stats_reset();
+	for (int i = 0; i < iterations; i++) {
+		if (i % 10 == 0)
+			phone_change_section(SM_SECTION_MUSIC);
+
+		uint64_t t0 = host_ns();
+		fake_click(BUTTON_ID_UP);
+		fake_advance_ms(250);
+		r.handler_ns += host_ns() - t0;
+	}
+	r.suppressed = sm_suppressed_updates() - suppressed;
+	r.stats = fake_stats;
+	phone_detach();
+	report(&r);
+}
+
+//three refresh commands at once, every fourth burst gets its first send NACKed
+static void bench_command_burst(void) {
+	Result r = {"command burst", iterations, 0, 0};
+
+	fake_stats_reset();
+	for (int i = 0; i < iterations; i++) {
+		if (i % 4 == 0)
+			fake_fail_next_sends(1);
+
+		uint64_t t0 = host_ns();
+		sendCommand(SM_STATUS_UPD_WEATHER_KEY);
+		sendCommand(SM_STATUS_UPD_CAL_KEY);
+		sendCommand(SM_SONG_LENGTH_KEY);
+		sendCommand(SM_STATUS_UPD_WEATHER_KEY);
+		r.handler_ns += host_ns() - t0;
+		fake_advance_ms(2000);
+	}
+	r.stats = fake_stats;
+	report(&r);
+}
+
+//refresh commands while the phone is away wait for the link instead of retrying
+static void bench_offline_commands(void) {
+	uint32_t retries = outbox_get_stats()->retries, offline_msgs, offline_wakeups;
+	FakeStats before;
+
+	fake_set_bluetooth(false);
+	fake_advance_ms(1000);
+	before = fake_stats;
+	sendCommand(SM_STATUS_UPD_WEATHER_KEY);
+	sendCommand(SM_STATUS_UPD_CAL_KEY);
+	fake_advance_ms(10 * 60 * 1000);
+	offline_msgs = fake_stats.msgs_out - before.msgs_out;
+	offline_wakeups = fake_stats.timer_wakeups - before.timer_wakeups;
+	retries = outbox_get_stats()->retries - retries;
+
+	before = fake_stats;
+	fake_set_bluetooth(true);
+	fake_advance_ms(100);
+	printf("%-18s offline 10 min: %u messages, %u retries, %u timer wakeups; link up: %u messages, %s\n",
+	       "offline commands", offline_msgs, retries, offline_wakeups, fake_stats.msgs_out - before.msgs_out,
+	       check(offline_msgs == 0 && retries == 0 && offline_wakeups == 0 && outbox_is_idle()
+	             && fake_stats.msgs_out - before.msgs_out == 1));
+	fake_advance_ms(120 * 1000);
+}
+
+static FakeStats init_stats, loop_stats;
+static uint32_t inbox_size, outbox_size;
+
+static void event_loop(void) {
+	//startup: the app sent SM_SCREEN_ENTER_KEY from window_appear, let it go out
+	fake_advance_ms(100);
+	init_stats = fake_stats;
+	inbox_size = fake_inbox_size();
+	outbox_size = fake_outbox_size();
+
+	report_header();
+	bench_status("status changing", true);
+	bench_status("status resend", false);
+	bench_resync_burst();
+	bench_out_of_order();
+	bench_poll_generations();
+	bench_phone_restart();
+	bench_minute_tick();
+	bench_refresh();
+	bench_command_burst();
+	bench_battery();
+	bench_link_flap();
+	bench_offline_commands();
+	bench_carousel();
+	bench_bitmap_stream();
+	bench_canvas();
+	bench_graph();
+	bench_marquee();
+	bench_idle_hour();
+	bench_governor();
+	bench_covered();
+	bench_covered_burst();
+	bench_full_redraw();
+
+#ifdef SM_DEBUG
+	//open the overlay once so it is built and drawn, then close it again
+	fake_long_click(BUTTON_ID_DOWN);
+	fake_render();
+	fake_long_click(BUTTON_ID_DOWN);
+	fake_render();
+#endif
+
+	//let the outbox drain so the screen exit sent from deinit is the only message left
+	fake_advance_ms(1000);
+	loop_stats = fake_stats;
+}
+
+#ifdef SM_TRACE
+static FILE *trace_file;
+
+static void trace_write(const uint8_t *data, size_t length) {
+	fwrite(data, 1, length, trace_file);
+}
+#endif
+
+int main(int argc, char **argv) {
+	for (int i = 1; i < argc; i++) {
+#ifdef SM_TRACE
+		//--record FILE writes the app's traffic during the run for bench/replay.c
+		if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+			trace_file = fopen(argv[++i], "wb");
+			if (!trace_file) {
+				perror(argv[i]);
+				return 1;
+			}
+			trace_set_writer(trace_write);
+			continue;
+		}
+#endif
+		iterations = atoi(argv[i]);
+	}
+	if (iterations <= 0) iterations = 1;
+
+	setenv("TZ", "UTC", 1);
+	tzset();
+
+	fake_set_event_loop(event_loop);
+	pebble_app_main();
+
+	printf("\n");
+	printf("startup            allocs %u, resource loads %u, heap after init %zu B (peak %zu B)\n",
+	       init_stats.allocs, init_stats.resource_loads, init_stats.heap_live, init_stats.heap_peak);
+	printf("app message        inbox %u B, outbox %u B\n", inbox_size, outbox_size);
+	printf("idle, per hour     %.1f messages out, %.1f timer wakeups\n",
+	       (double)idle_stats.msgs_out / idle_hours, (double)idle_stats.timer_wakeups / idle_hours);
+	printf("reconnect          %u resyncs, %u drops, %u flaps, latency %u ms (max %u ms)\n",
+	       link_get_stats()->resyncs, link_get_stats()->drops, link_get_stats()->flaps,
+	       link_get_stats()->last_latency_ms, link_get_stats()->max_latency_ms);
+	printf("carousel           %u presses, %u slides, %u coalesced\n",
+	       carousel_get_stats()->presses, carousel_get_stats()->slides, carousel_get_stats()->coalesced);
+#ifdef SM_DEBUG
+	printf("debug counters     in %u msgs %u B, out %u msgs %u failed, rcv max %u ms, draws %u/%u/%u, heap low %u B\n",
+	       debug_stats.messages_in, debug_stats.bytes_in, debug_stats.messages_out, debug_stats.outbox_failures,
+	       debug_stats.max_ms[DEBUG_RCV], debug_stats.calls[DEBUG_DRAW_GAUGE], debug_stats.calls[DEBUG_DRAW_CANVAS],
+	       debug_stats.calls[DEBUG_DRAW_GRAPH], debug_stats.heap_low);
+#endif
+	printf("exit               %u messages out, %s\n", fake_stats.msgs_out - loop_stats.msgs_out,
+	       check(fake_stats.msgs_out - loop_stats.msgs_out == 1));
+	printf("after deinit       heap %zu B still allocated, %s\n", fake_stats.heap_live, check(fake_stats.heap_live == 0));
+#ifdef SM_TRACE
+	if (trace_file)
+		fclose(trace_file);
+#endif
+	if (failed_checks) {
+		printf("%d checks failed\n", failed_checks);
+		return 1;
+	}
+	return 0;
+}
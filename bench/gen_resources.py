@@ -0,0 +1,49 @@
+#!/usr/bin/env python3
+#
+# Generates the RESOURCE_ID_* enum that the Pebble SDK would normally produce
+# from appinfo.json, plus a table of resource sizes for the fake SDK.
+#
+
+import json
+import os
+import struct
+import sys
+
+
+def png_size(path):
+    with open(path, 'rb') as f:
+        header = f.read(24)
+    return struct.unpack('>II', header[16:24])
+
+
+def main(appinfo_path, out_dir):
+    root = os.path.dirname(os.path.abspath(appinfo_path))
+    with open(appinfo_path) as f:
+        media = json.load(f)['resources']['media']
+
+    ids = []
+    table = []
+    for res in media:
+        path = os.path.join(root, 'resources', res['file'])
+        width = height = 0
+        if res['type'] == 'png':
+            width, height = png_size(path)
+        ids.append(res['name'])
+        table.append('\t{"%s", %d, %d, %d},' % (res['name'], width, height, os.path.getsize(path)))
+
+    with open(os.path.join(out_dir, 'resource_ids.auto.h'), 'w') as f:
+        f.write('#pragma once\n\n//generated by bench/gen_resources.py from appinfo.json\n\n')
+        f.write('typedef enum {\n\tINVALID_RESOURCE = 0,\n')
+        for name in ids:
+            f.write('\tRESOURCE_ID_%s,\n' % name)
+        f.write('\tNUM_RESOURCE_IDS\n} ResourceId;\n')
+
+    with open(os.path.join(out_dir, 'fake_resources.auto.h'), 'w') as f:
+        f.write('#pragma once\n\n//generated by bench/gen_resources.py from appinfo.json\n\n')
+        f.write('static const FakeResource fake_resources[] = {\n\t{"INVALID_RESOURCE", 0, 0, 0},\n')
+        f.write('\n'.join(table))
+        f.write('\n};\n')
+
+
+if __name__ == '__main__':
+    main(sys.argv[1], sys.argv[2])
@@ -0,0 +1,96 @@
+#ifndef _fake_h
+#define _fake_h
+
+//host-side controls for the fake Pebble SDK, used by the bench driver only
+
+#include <pebble.h>
+
+typedef struct {
+	const char *name;
+	int width;
+	int height;
+	int file_size;
+} FakeResource;
+
+typedef struct {
+	//heap
+	uint32_t allocs;
+	uint32_t frees;
+	size_t heap_live;
+	size_t heap_peak;
+
+	//rendering
+	uint32_t frames;
+	uint32_t layer_draws;
+	uint32_t dirty_marks;
+	uint32_t text_sets;
+	uint32_t glyphs;
+	uint32_t draw_ops;
+	uint32_t bitmap_bytes_blitted;
+
+	//event sources
+	uint32_t timer_registers;
+	uint32_t timer_cancels;
+	uint32_t timer_wakeups;
+	uint32_t ticks;
+	uint32_t clock_style_checks;
+	uint32_t animations_created;
+	uint32_t animations_scheduled;
+	uint32_t animation_steps;
+	uint32_t vibes;
+
+	//app messages
+	uint32_t msgs_in;
+	uint32_t bytes_in;
+	uint32_t msgs_dropped;
+	uint32_t msgs_out;
+	uint32_t bytes_out;
+	uint32_t outbox_busy;
+	uint32_t outbox_failed;
+
+	//storage and resources
+	uint32_t persist_reads;
+	uint32_t persist_writes;
+	uint32_t persist_bytes_written;
+	uint32_t resource_loads;
+	uint32_t font_loads;
+	uint32_t font_unloads;
+} FakeStats;
+
+extern FakeStats fake_stats;
+
+typedef void (*FakeEventLoopBody)(void);
+typedef void (*FakeOutboxObserver)(DictionaryIterator *iter, void *context);
+
+void fake_stats_reset(void);
+void fake_set_event_loop(FakeEventLoopBody body);
+
+//clock: all timers, ticks, animations and message acks run off a mock clock
+void fake_set_time(time_t t);
+uint64_t fake_now_ms(void);
+void fake_advance_ms(uint32_t ms);
+void fake_set_24h_style(bool is_24h);
+
+//rendering: a frame redraws every visible layer, like the firmware does
+void fake_render(void);
+void fake_invalidate(void);
+uint32_t fake_layer_draws(const Layer *layer);
+
+//app messages
+void fake_deliver(const uint8_t *buffer, uint16_t size);
+void fake_queue_inbound(const uint8_t *buffer, uint16_t size, uint32_t delay_ms);
+void fake_set_outbox_observer(FakeOutboxObserver observer, void *context);
+void fake_set_outbox_latency(uint32_t ms);
+void fake_fail_next_sends(int count);
+uint32_t fake_inbox_size(void);
+uint32_t fake_outbox_size(void);
+
+//services and input
+void fake_set_bluetooth(bool connected);
+void fake_set_battery(BatteryChargeState state);
+void fake_set_window_covered(bool covered);
+void fake_click(ButtonId button);
+void fake_long_click(ButtonId button);
+void fake_persist_clear(void);
+
+#endif
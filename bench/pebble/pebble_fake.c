@@ -0,0 +1,1474 @@
+#include <stdarg.h>
+#include "fake.h"
+
+//the fake itself uses the host allocator
+#undef malloc
+#undef calloc
+#undef realloc
+#undef free
+#undef time
+
+#include "fake_resources.auto.h"
+
+#define FAKE_HEAP_SIZE			(24 * 1024)
+#define FAKE_INBOX_MAXIMUM		2026
+#define FAKE_OUTBOX_MAXIMUM		656
+#define FAKE_FRAME_MS			33
+#define FAKE_MAX_PERSIST		64
+#define FAKE_MAX_INBOUND		64
+#define HEAP_HEADER				16
+
+FakeStats fake_stats;
+
+static FakeEventLoopBody event_loop_body;
+static uint64_t now_ms = 1767603540000ULL;	//2026-01-05 08:59:00 UTC
+static bool is_24h = true;
+static bool render_pending;
+
+//--- heap
+
+void *fake_malloc(size_t size) {
+	if (fake_stats.heap_live + size + HEAP_HEADER > FAKE_HEAP_SIZE)
+		return NULL;
+
+	uint8_t *p = malloc(size + HEAP_HEADER);
+	if (!p) return NULL;
+	*(size_t*)p = size;
+
+	fake_stats.allocs++;
+	fake_stats.heap_live += size + HEAP_HEADER;
+	if (fake_stats.heap_live > fake_stats.heap_peak)
+		fake_stats.heap_peak = fake_stats.heap_live;
+	return p + HEAP_HEADER;
+}
+
+void *fake_calloc(size_t count, size_t size) {
+	void *p = fake_malloc(count * size);
+	if (p) memset(p, 0, count * size);
+	return p;
+}
+
+void fake_free(void *ptr) {
+	if (!ptr) return;
+	uint8_t *p = (uint8_t*)ptr - HEAP_HEADER;
+	fake_stats.frees++;
+	fake_stats.heap_live -= *(size_t*)p + HEAP_HEADER;
+	free(p);
+}
+
+void *fake_realloc(void *ptr, size_t size) {
+	void *p = fake_malloc(size);
+	if (p && ptr) {
+		size_t old = *(size_t*)((uint8_t*)ptr - HEAP_HEADER);
+		memcpy(p, ptr, old < size ? old : size);
+		fake_free(ptr);
+	}
+	return p;
+}
+
+size_t heap_bytes_free(void) {
+	return FAKE_HEAP_SIZE - fake_stats.heap_live;
+}
+
+size_t heap_bytes_used(void) {
+	return fake_stats.heap_live;
+}
+
+void fake_stats_reset(void) {
+	size_t live = fake_stats.heap_live;
+	memset(&fake_stats, 0, sizeof(fake_stats));
+	fake_stats.heap_live = live;
+	fake_stats.heap_peak = live;
+}
+
+//--- time and logging
+
+time_t fake_time(time_t *tloc) {
+	time_t t = (time_t)(now_ms / 1000);
+	if (tloc) *tloc = t;
+	return t;
+}
+
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms) {
+	uint16_t ms = (uint16_t)(now_ms % 1000);
+	if (tloc) *tloc = (time_t)(now_ms / 1000);
+	if (out_ms) *out_ms = ms;
+	return ms;
+}
+
+static uint64_t next_tick_ms;
+static uint64_t tick_period_ms(void);
+
+void fake_set_time(time_t t) {
+	now_ms = (uint64_t)t * 1000;
+	next_tick_ms = (now_ms / tick_period_ms() + 1) * tick_period_ms();
+}
+
+uint64_t fake_now_ms(void) {
+	return now_ms;
+}
+
+bool clock_is_24h_style(void) {
+	fake_stats.clock_style_checks++;
+	return is_24h;
+}
+
+void fake_set_24h_style(bool style) {
+	is_24h = style;
+}
+
+void app_log(uint8_t log_level, const char *src_filename, int src_line_number, const char *fmt, ...) {
+	if (!getenv("SMBENCH_LOG")) return;
+
+	va_list args;
+	va_start(args, fmt);
+	fprintf(stderr, "[%u] %s:%d ", log_level, src_filename, src_line_number);
+	vfprintf(stderr, fmt, args);
+	fprintf(stderr, "\n");
+	va_end(args);
+}
+
+//--- geometry
+
+bool gpoint_equal(const GPoint * const a, const GPoint * const b) {
+	return a->x == b->x && a->y == b->y;
+}
+
+bool grect_equal(const GRect * const a, const GRect * const b) {
+	return gpoint_equal(&a->origin, &b->origin) && a->size.w == b->size.w && a->size.h == b->size.h;
+}
+
+//--- resources and bitmaps
+
+#define NUM_FAKE_RESOURCES ((uint32_t)(sizeof(fake_resources) / sizeof(fake_resources[0])))
+#define GBITMAP_OWNS_DATA 0x1
+
+static uint16_t row_bytes(int width) {
+	return (uint16_t)(((width + 31) / 32) * 4);
+}
+
+static GBitmap *bitmap_alloc(GSize size) {
+	size_t data = (size_t)row_bytes(size.w) * size.h;
+	GBitmap *bmp = fake_malloc(sizeof(GBitmap) + data);
+	if (!bmp) return NULL;
+
+	memset(bmp, 0, sizeof(GBitmap) + data);
+	bmp->addr = bmp + 1;
+	bmp->row_size_bytes = row_bytes(size.w);
+	bmp->info_flags = GBITMAP_OWNS_DATA;
+	bmp->bounds = GRect(0, 0, size.w, size.h);
+	return bmp;
+}
+
+ResHandle resource_get_handle(uint32_t resource_id) {
+	return (ResHandle)(uintptr_t)resource_id;
+}
+
+size_t resource_size(ResHandle h) {
+	uint32_t id = (uint32_t)(uintptr_t)h;
+	return id < NUM_FAKE_RESOURCES ? (size_t)fake_resources[id].file_size : 0;
+}
+
+size_t resource_load(ResHandle h, uint8_t *buffer, size_t max_length) {
+	size_t size = resource_size(h);
+	if (size > max_length) size = max_length;
+	memset(buffer, 0, size);
+	fake_stats.resource_loads++;
+	return size;
+}
+
+GBitmap *gbitmap_create_with_resource(uint32_t resource_id) {
+	if (resource_id == 0 || resource_id >= NUM_FAKE_RESOURCES || fake_resources[resource_id].width == 0)
+		return NULL;
+
+	fake_stats.resource_loads++;
+	return bitmap_alloc(GSize(fake_resources[resource_id].width, fake_resources[resource_id].height));
+}
+
+GBitmap *gbitmap_create_as_sub_bitmap(const GBitmap *base, GRect sub_rect) {
+	GBitmap *bmp = fake_malloc(sizeof(GBitmap));
+	if (!bmp) return NULL;
+
+	*bmp = *base;
+	bmp->info_flags &= ~GBITMAP_OWNS_DATA;
+	bmp->bounds.origin.x = base->bounds.origin.x + sub_rect.origin.x;
+	bmp->bounds.origin.y = base->bounds.origin.y + sub_rect.origin.y;
+	bmp->bounds.size = sub_rect.size;
+	return bmp;
+}
+
+GBitmap *gbitmap_create_blank(GSize size) {
+	return bitmap_alloc(size);
+}
+
+void gbitmap_destroy(GBitmap *bitmap) {
+	fake_free(bitmap);
+}
+
+//--- fonts
+
+struct FontInfo {
+	int16_t height;
+	bool bold;
+	bool custom;
+};
+
+static struct FontInfo system_fonts[] = {
+	{14, false, false}, {14, true, false},
+	{18, false, false}, {18, true, false},
+	{24, false, false}, {24, true, false},
+	{28, false, false}, {28, true, false},
+};
+
+static int16_t height_from_name(const char *name) {
+	const char *p = name + strlen(name);
+	while (p > name && !(p[-1] >= '0' && p[-1] <= '9')) p--;
+	while (p > name && p[-1] >= '0' && p[-1] <= '9') p--;
+	return (int16_t)(atoi(p) > 0 ? atoi(p) : 18);
+}
+
+GFont fonts_get_system_font(const char *font_key) {
+	int16_t height = height_from_name(font_key);
+	bool bold = strstr(font_key, "BOLD") != NULL;
+
+	for (size_t i = 0; i < sizeof(system_fonts) / sizeof(system_fonts[0]); i++) {
+		if (system_fonts[i].height == height && system_fonts[i].bold == bold)
+			return &system_fonts[i];
+	}
+	return &system_fonts[2];
+}
+
+GFont fonts_load_custom_font(ResHandle handle) {
+	uint32_t id = (uint32_t)(uintptr_t)handle;
+	struct FontInfo *font = fake_malloc(sizeof(struct FontInfo) + 64);
+	if (!font) return NULL;
+
+	font->height = id < NUM_FAKE_RESOURCES ? height_from_name(fake_resources[id].name) : 18;
+	font->bold = id < NUM_FAKE_RESOURCES && strstr(fake_resources[id].name, "BOLD") != NULL;
+	font->custom = true;
+	fake_stats.resource_loads++;
+	fake_stats.font_loads++;
+	return font;
+}
+
+void fonts_unload_custom_font(GFont font) {
+	if (!font || !font->custom) return;
+	fake_stats.font_unloads++;
+	fake_free(font);
+}
+
+static int16_t glyph_advance(GFont font) {
+	int16_t h = font ? font->height : 18;
+	return (int16_t)(h / 2 + ((font && font->bold) ? 1 : 0));
+}
+
+static int16_t line_height(GFont font) {
+	return (int16_t)((font ? font->height : 18) + 2);
+}
+
+//--- graphics
+
+struct GContext {
+	GPoint offset;
+	GColor stroke, fill, text;
+	GCompOp comp;
+};
+
+static GContext screen_ctx;
+
+void graphics_context_set_stroke_color(GContext *ctx, GColor color) { ctx->stroke = color; }
+void graphics_context_set_fill_color(GContext *ctx, GColor color) { ctx->fill = color; }
+void graphics_context_set_text_color(GContext *ctx, GColor color) { ctx->text = color; }
+void graphics_context_set_compositing_mode(GContext *ctx, GCompOp mode) { ctx->comp = mode; }
+
+void graphics_draw_pixel(GContext *ctx, GPoint point) {
+	fake_stats.draw_ops++;
+}
+
+void graphics_draw_line(GContext *ctx, GPoint p0, GPoint p1) {
+	fake_stats.draw_ops++;
+}
+
+void graphics_draw_rect(GContext *ctx, GRect rect) {
+	fake_stats.draw_ops++;
+}
+
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask) {
+	fake_stats.draw_ops++;
+}
+
+void graphics_draw_bitmap_in_rect(GContext *ctx, const GBitmap *bitmap, GRect rect) {
+	if (!bitmap) return;
+	int w = rect.size.w < bitmap->bounds.size.w ? rect.size.w : bitmap->bounds.size.w;
+	int h = rect.size.h < bitmap->bounds.size.h ? rect.size.h : bitmap->bounds.size.h;
+	fake_stats.draw_ops++;
+	fake_stats.bitmap_bytes_blitted += (uint32_t)(row_bytes(w) * h);
+}
+
+//approximates word wrapped layout with a fixed advance per glyph; returns glyphs laid out
+static uint32_t layout_text(const char *text, GFont font, GRect box, GTextOverflowMode overflow, GSize *size) {
+	size_t len = text ? strlen(text) : 0;
+	int16_t advance = glyph_advance(font);
+	int16_t lh = line_height(font);
+	int per_line = box.size.w / advance;
+	int max_lines = box.size.h / lh;
+
+	if (per_line < 1) per_line = 1;
+	if (max_lines < 1) max_lines = 1;
+
+	int lines = (int)((len + per_line - 1) / per_line);
+	if (lines > max_lines) lines = max_lines;
+
+	size_t glyphs = (size_t)lines * per_line;
+	if (glyphs > len) glyphs = len;
+
+	if (size) {
+		size->w = (int16_t)((len < (size_t)per_line ? len : (size_t)per_line) * advance);
+		size->h = (int16_t)(lines * lh);
+	}
+	return (uint32_t)glyphs;
+}
+
+void graphics_draw_text(GContext *ctx, const char *text, const GFont font, const GRect box,
+                        const GTextOverflowMode overflow_mode, const GTextAlignment alignment,
+                        const GTextLayoutCacheRef layout) {
+	fake_stats.draw_ops++;
+	fake_stats.glyphs += layout_text(text, font, box, overflow_mode, NULL);
+}
+
+GSize graphics_text_layout_get_content_size(const char *text, const GFont font, const GRect box,
+                                            const GTextOverflowMode overflow_mode,
+                                            const GTextAlignment alignment) {
+	GSize size;
+	fake_stats.glyphs += layout_text(text, font, box, overflow_mode, &size);
+	return size;
+}
+
+//--- layers
+
+struct Layer {
+	GRect frame;
+	GRect bounds;
+	bool hidden;
+	bool clips;
+	Layer *parent;
+	Layer *first_child;
+	Layer *next_sibling;
+	LayerUpdateProc update_proc;
+	uint32_t draws;
+	void *data;
+};
+
+struct TextLayer {
+	Layer layer;
+	const char *text;
+	GFont font;
+	GColor text_color;
+	GColor background_color;
+	GTextAlignment alignment;
+	GTextOverflowMode overflow;
+};
+
+struct BitmapLayer {
+	Layer layer;
+	const GBitmap *bitmap;
+	GAlign alignment;
+	GColor background_color;
+	GCompOp compositing_mode;
+};
+
+static void layer_init(Layer *layer, GRect frame) {
+	memset(layer, 0, sizeof(*layer));
+	layer->frame = frame;
+	layer->bounds = GRect(0, 0, frame.size.w, frame.size.h);
+	layer->clips = true;
+}
+
+Layer *layer_create(GRect frame) {
+	return layer_create_with_data(frame, 0);
+}
+
+Layer *layer_create_with_data(GRect frame, size_t data_size) {
+	Layer *layer = fake_malloc(sizeof(Layer) + data_size);
+	if (!layer) return NULL;
+
+	layer_init(layer, frame);
+	if (data_size) {
+		layer->data = layer + 1;
+		memset(layer->data, 0, data_size);
+	}
+	return layer;
+}
+
+void *layer_get_data(const Layer *layer) {
+	return layer->data;
+}
+
+static void layer_detach(Layer *layer) {
+	layer_remove_from_parent(layer);
+	for (Layer *c = layer->first_child; c; ) {
+		Layer *next = c->next_sibling;
+		c->parent = NULL;
+		c->next_sibling = NULL;
+		c = next;
+	}
+	layer->first_child = NULL;
+}
+
+void layer_destroy(Layer *layer) {
+	if (!layer) return;
+	layer_detach(layer);
+	fake_free(layer);
+}
+
+void layer_mark_dirty(Layer *layer) {
+	fake_stats.dirty_marks++;
+	render_pending = true;
+}
+
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc) {
+	layer->update_proc = update_proc;
+}
+
+void layer_set_frame(Layer *layer, GRect frame) {
+	if (grect_equal(&layer->frame, &frame)) return;
+	layer->frame = frame;
+	layer->bounds.size = frame.size;
+	layer_mark_dirty(layer);
+}
+
+GRect layer_get_frame(const Layer *layer) {
+	return layer->frame;
+}
+
+void layer_set_bounds(Layer *layer, GRect bounds) {
+	if (grect_equal(&layer->bounds, &bounds)) return;
+	layer->bounds = bounds;
+	layer_mark_dirty(layer);
+}
+
+GRect layer_get_bounds(const Layer *layer) {
+	return layer->bounds;
+}
+
+void layer_add_child(Layer *parent, Layer *child) {
+	layer_remove_from_parent(child);
+	child->parent = parent;
+	if (!parent->first_child) {
+		parent->first_child = child;
+	} else {
+		Layer *c = parent->first_child;
+		while (c->next_sibling) c = c->next_sibling;
+		c->next_sibling = child;
+	}
+	layer_mark_dirty(parent);
+}
+
+void layer_remove_from_parent(Layer *child) {
+	Layer *parent = child->parent;
+	if (!parent) return;
+
+	Layer **link = &parent->first_child;
+	while (*link && *link != child) link = &(*link)->next_sibling;
+	if (*link) *link = child->next_sibling;
+	child->parent = NULL;
+	child->next_sibling = NULL;
+	layer_mark_dirty(parent);
+}
+
+void layer_set_hidden(Layer *layer, bool hidden) {
+	if (layer->hidden == hidden) return;
+	layer->hidden = hidden;
+	layer_mark_dirty(layer);
+}
+
+bool layer_get_hidden(const Layer *layer) {
+	return layer->hidden;
+}
+
+void layer_set_clips(Layer *layer, bool clips) {
+	layer->clips = clips;
+}
+
+uint32_t fake_layer_draws(const Layer *layer) {
+	return layer ? layer->draws : 0;
+}
+
+static void text_layer_update_proc(Layer *layer, GContext *ctx) {
+	TextLayer *tl = (TextLayer*)layer;
+	if (tl->background_color != GColorClear) {
+		graphics_context_set_fill_color(ctx, tl->background_color);
+		graphics_fill_rect(ctx, layer->bounds, 0, GCornerNone);
+	}
+	if (tl->text) {
+		graphics_context_set_text_color(ctx, tl->text_color);
+		graphics_draw_text(ctx, tl->text, tl->font, layer->bounds, tl->overflow, tl->alignment, NULL);
+	}
+}
+
+TextLayer *text_layer_create(GRect frame) {
+	TextLayer *tl = fake_malloc(sizeof(TextLayer));
+	if (!tl) return NULL;
+
+	layer_init(&tl->layer, frame);
+	tl->layer.update_proc = text_layer_update_proc;
+	tl->text = NULL;
+	tl->font = fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD);
+	tl->text_color = GColorBlack;
+	tl->background_color = GColorWhite;
+	tl->alignment = GTextAlignmentLeft;
+	tl->overflow = GTextOverflowModeWordWrap;
+	return tl;
+}
+
+void text_layer_destroy(TextLayer *text_layer) {
+	if (!text_layer) return;
+	layer_detach(&text_layer->layer);
+	fake_free(text_layer);
+}
+
+Layer *text_layer_get_layer(TextLayer *text_layer) {
+	return &text_layer->layer;
+}
+
+void text_layer_set_text(TextLayer *text_layer, const char *text) {
+	fake_stats.text_sets++;
+	text_layer->text = text;
+	layer_mark_dirty(&text_layer->layer);
+}
+
+const char *text_layer_get_text(TextLayer *text_layer) {
+	return text_layer->text;
+}
+
+void text_layer_set_background_color(TextLayer *text_layer, GColor color) {
+	text_layer->background_color = color;
+	layer_mark_dirty(&text_layer->layer);
+}
+
+void text_layer_set_text_color(TextLayer *text_layer, GColor color) {
+	text_layer->text_color = color;
+	layer_mark_dirty(&text_layer->layer);
+}
+
+void text_layer_set_overflow_mode(TextLayer *text_layer, GTextOverflowMode line_mode) {
+	text_layer->overflow = line_mode;
+	layer_mark_dirty(&text_layer->layer);
+}
+
+void text_layer_set_font(TextLayer *text_layer, GFont font) {
+	text_layer->font = font;
+	layer_mark_dirty(&text_layer->layer);
+}
+
+void text_layer_set_text_alignment(TextLayer *text_layer, GTextAlignment text_alignment) {
+	text_layer->alignment = text_alignment;
+	layer_mark_dirty(&text_layer->layer);
+}
+
+GSize text_layer_get_content_size(TextLayer *text_layer) {
+	GSize size;
+	layout_text(text_layer->text, text_layer->font, text_layer->layer.bounds, text_layer->overflow, &size);
+	return size;
+}
+
+static void bitmap_layer_update_proc(Layer *layer, GContext *ctx) {
+	BitmapLayer *bl = (BitmapLayer*)layer;
+	if (bl->background_color != GColorClear) {
+		graphics_context_set_fill_color(ctx, bl->background_color);
+		graphics_fill_rect(ctx, layer->bounds, 0, GCornerNone);
+	}
+	graphics_draw_bitmap_in_rect(ctx, bl->bitmap, layer->bounds);
+}
+
+BitmapLayer *bitmap_layer_create(GRect frame) {
+	BitmapLayer *bl = fake_malloc(sizeof(BitmapLayer));
+	if (!bl) return NULL;
+
+	layer_init(&bl->layer, frame);
+	bl->layer.update_proc = bitmap_layer_update_proc;
+	bl->bitmap = NULL;
+	bl->alignment = GAlignCenter;
+	bl->background_color = GColorClear;
+	bl->compositing_mode = GCompOpAssign;
+	return bl;
+}
+
+void bitmap_layer_destroy(BitmapLayer *bitmap_layer) {
+	if (!bitmap_layer) return;
+	layer_detach(&bitmap_layer->layer);
+	fake_free(bitmap_layer);
+}
+
+Layer *bitmap_layer_get_layer(const BitmapLayer *bitmap_layer) {
+	return (Layer*)&bitmap_layer->layer;
+}
+
+void bitmap_layer_set_bitmap(BitmapLayer *bitmap_layer, const GBitmap *bitmap) {
+	bitmap_layer->bitmap = bitmap;
+	layer_mark_dirty(&bitmap_layer->layer);
+}
+
+void bitmap_layer_set_alignment(BitmapLayer *bitmap_layer, GAlign alignment) {
+	bitmap_layer->alignment = alignment;
+	layer_mark_dirty(&bitmap_layer->layer);
+}
+
+void bitmap_layer_set_background_color(BitmapLayer *bitmap_layer, GColor color) {
+	bitmap_layer->background_color = color;
+	layer_mark_dirty(&bitmap_layer->layer);
+}
+
+void bitmap_layer_set_compositing_mode(BitmapLayer *bitmap_layer, GCompOp mode) {
+	bitmap_layer->compositing_mode = mode;
+	layer_mark_dirty(&bitmap_layer->layer);
+}
+
+//--- windows, clicks and rendering
+
+typedef struct {
+	ClickHandler single;
+	ClickHandler raw_down;
+	ClickHandler raw_up;
+	void *raw_context;
+	ClickHandler long_down;
+	ClickHandler long_up;
+} ClickConfig;
+
+struct Window {
+	Layer root;
+	WindowHandlers handlers;
+	ClickConfigProvider click_config_provider;
+	void *click_context;
+	ClickConfig clicks[NUM_BUTTONS];
+	bool loaded;
+	bool visible;
+};
+
+static Window *top_window;
+static Window *configuring_window;
+
+Window *window_create(void) {
+	Window *window = fake_calloc(1, sizeof(Window));
+	if (!window) return NULL;
+
+	layer_init(&window->root, GRect(0, 0, 144, 168));
+	return window;
+}
+
+void window_destroy(Window *window) {
+	if (!window) return;
+	if (top_window == window) window_stack_pop(false);
+	layer_detach(&window->root);
+	fake_free(window);
+}
+
+void window_set_click_config_provider(Window *window, ClickConfigProvider click_config_provider) {
+	window_set_click_config_provider_with_context(window, click_config_provider, window);
+}
+
+void window_set_click_config_provider_with_context(Window *window, ClickConfigProvider click_config_provider, void *context) {
+	window->click_config_provider = click_config_provider;
+	window->click_context = context;
+}
+
+void window_set_window_handlers(Window *window, WindowHandlers handlers) {
+	window->handlers = handlers;
+}
+
+void window_set_fullscreen(Window *window, bool enabled) {
+}
+
+void window_set_background_color(Window *window, GColor background_color) {
+}
+
+Layer *window_get_root_layer(const Window *window) {
+	return (Layer*)&window->root;
+}
+
+void window_stack_push(Window *window, bool animated) {
+	top_window = window;
+	memset(window->clicks, 0, sizeof(window->clicks));
+	if (window->click_config_provider) {
+		configuring_window = window;
+		window->click_config_provider(window->click_context);
+		configuring_window = NULL;
+	}
+	if (!window->loaded) {
+		window->loaded = true;
+		if (window->handlers.load) window->handlers.load(window);
+	}
+	window->visible = true;
+	if (window->handlers.appear) window->handlers.appear(window);
+	render_pending = true;
+}
+
+Window *window_stack_pop(bool animated) {
+	Window *window = top_window;
+	if (!window) return NULL;
+
+	if (window->visible && window->handlers.disappear) window->handlers.disappear(window);
+	window->visible = false;
+	if (window->loaded && window->handlers.unload) window->handlers.unload(window);
+	window->loaded = false;
+	top_window = NULL;
+	return window;
+}
+
+bool window_stack_remove(Window *window, bool animated) {
+	if (!window || top_window != window) return false;
+	window_stack_pop(animated);
+	return true;
+}
+
+void fake_set_window_covered(bool covered) {
+	if (!top_window || top_window->visible == !covered) return;
+
+	top_window->visible = !covered;
+	if (covered) {
+		if (top_window->handlers.disappear) top_window->handlers.disappear(top_window);
+	} else {
+		if (top_window->handlers.appear) top_window->handlers.appear(top_window);
+		render_pending = true;
+	}
+	fake_render();
+}
+
+void window_single_click_subscribe(ButtonId button_id, ClickHandler handler) {
+	configuring_window->clicks[button_id].single = handler;
+}
+
+void window_raw_click_subscribe(ButtonId button_id, ClickHandler down_handler, ClickHandler up_handler, void *context) {
+	configuring_window->clicks[button_id].raw_down = down_handler;
+	configuring_window->clicks[button_id].raw_up = up_handler;
+	configuring_window->clicks[button_id].raw_context = context;
+}
+
+void window_long_click_subscribe(ButtonId button_id, uint16_t delay_ms, ClickHandler down_handler, ClickHandler up_handler) {
+	configuring_window->clicks[button_id].long_down = down_handler;
+	configuring_window->clicks[button_id].long_up = up_handler;
+}
+
+static void click(ButtonId button, bool is_long) {
+	if (!top_window || !top_window->visible) return;
+
+	ClickConfig *c = &top_window->clicks[button];
+	void *context = top_window->click_context;
+
+	if (c->raw_down) c->raw_down(NULL, c->raw_context);
+	if (is_long && c->long_down) {
+		c->long_down(NULL, context);
+		if (c->long_up) c->long_up(NULL, context);
+	} else if (c->single) {
+		c->single(NULL, context);
+	}
+	if (c->raw_up) c->raw_up(NULL, c->raw_context);
+	fake_render();
+}
+
+void fake_click(ButtonId button) {
+	click(button, false);
+}
+
+void fake_long_click(ButtonId button) {
+	click(button, true);
+}
+
+static void draw_tree(Layer *layer, GContext *ctx) {
+	if (layer->hidden) return;
+
+	layer->draws++;
+	fake_stats.layer_draws++;
+	if (layer->update_proc) layer->update_proc(layer, ctx);
+	for (Layer *c = layer->first_child; c; c = c->next_sibling)
+		draw_tree(c, ctx);
+}
+
+void fake_render(void) {
+	if (!render_pending || !top_window || !top_window->visible) return;
+
+	render_pending = false;
+	fake_stats.frames++;
+	draw_tree(&top_window->root, &screen_ctx);
+}
+
+void fake_invalidate(void) {
+	render_pending = true;
+}
+
+//--- animations
+
+static Animation *scheduled_animations;
+
+PropertyAnimation *property_animation_create_layer_frame(struct Layer *layer, GRect *from_frame, GRect *to_frame) {
+	PropertyAnimation *ani = fake_calloc(1, sizeof(PropertyAnimation));
+	if (!ani) return NULL;
+
+	ani->subject = layer;
+	ani->values.from.grect = from_frame ? *from_frame : layer->frame;
+	ani->values.to.grect = to_frame ? *to_frame : layer->frame;
+	ani->animation.duration_ms = 250;
+	ani->animation.curve = AnimationCurveEaseInOut;
+	fake_stats.animations_created++;
+	return ani;
+}
+
+static void animation_remove(Animation *animation) {
+	Animation **link = &scheduled_animations;
+	while (*link && *link != animation) link = &(*link)->next_scheduled;
+	if (*link) *link = animation->next_scheduled;
+	animation->next_scheduled = NULL;
+	animation->is_scheduled = false;
+}
+
+void animation_unschedule(Animation *animation) {
+	if (!animation || !animation->is_scheduled) return;
+	animation_remove(animation);
+	if (animation->handlers.stopped) animation->handlers.stopped(animation, false, animation->context);
+}
+
+void animation_schedule(Animation *animation) {
+	if (!animation) return;
+	animation_unschedule(animation);
+
+	animation->abs_start_time_ms = now_ms + animation->delay_ms;
+	animation->is_scheduled = true;
+	animation->next_scheduled = scheduled_animations;
+	scheduled_animations = animation;
+	fake_stats.animations_scheduled++;
+	if (animation->handlers.started) animation->handlers.started(animation, animation->context);
+}
+
+void property_animation_destroy(PropertyAnimation *property_animation) {
+	if (!property_animation) return;
+	animation_unschedule(&property_animation->animation);
+	fake_free(property_animation);
+}
+
+bool animation_is_scheduled(Animation *animation) {
+	return animation && animation->is_scheduled;
+}
+
+void animation_set_delay(Animation *animation, uint32_t delay_ms) {
+	animation->delay_ms = delay_ms;
+}
+
+void animation_set_duration(Animation *animation, uint32_t duration_ms) {
+	animation->duration_ms = duration_ms;
+}
+
+void animation_set_curve(Animation *animation, AnimationCurve curve) {
+	animation->curve = curve;
+}
+
+void animation_set_handlers(Animation *animation, AnimationHandlers callbacks, void *context) {
+	animation->handlers = callbacks;
+	animation->context = context;
+}
+
+static int16_t lerp(int16_t from, int16_t to, uint32_t num, uint32_t den) {
+	return (int16_t)(from + ((int32_t)(to - from) * (int32_t)num) / (int32_t)den);
+}
+
+static void step_animations(void) {
+	Animation *a = scheduled_animations;
+	while (a) {
+		Animation *next = a->next_scheduled;
+		if (now_ms >= a->abs_start_time_ms) {
+			PropertyAnimation *pa = (PropertyAnimation*)a;
+			uint32_t elapsed = (uint32_t)(now_ms - a->abs_start_time_ms);
+			uint32_t duration = a->duration_ms ? a->duration_ms : 1;
+			if (elapsed > duration) elapsed = duration;
+
+			GRect f = pa->values.from.grect, t = pa->values.to.grect;
+			layer_set_frame(pa->subject, GRect(lerp(f.origin.x, t.origin.x, elapsed, duration),
+			                                   lerp(f.origin.y, t.origin.y, elapsed, duration),
+			                                   lerp(f.size.w, t.size.w, elapsed, duration),
+			                                   lerp(f.size.h, t.size.h, elapsed, duration)));
+			fake_stats.animation_steps++;
+
+			if (elapsed >= duration) {
+				animation_remove(a);
+				if (a->handlers.stopped) a->handlers.stopped(a, true, a->context);
+			}
+		}
+		a = next;
+	}
+}
+
+//--- timers
+
+struct AppTimer {
+	uint32_t id;
+	uint64_t deadline;
+	AppTimerCallback callback;
+	void *data;
+	struct AppTimer *next;
+};
+
+static struct AppTimer *timers;
+static uint32_t next_timer_id = 1;
+
+static struct AppTimer *timer_find(AppTimer *handle) {
+	uint32_t id = (uint32_t)(uintptr_t)handle;
+	for (struct AppTimer *t = timers; t; t = t->next) {
+		if (t->id == id) return t;
+	}
+	return NULL;
+}
+
+static void timer_unlink(struct AppTimer *timer) {
+	struct AppTimer **link = &timers;
+	while (*link != timer) link = &(*link)->next;
+	*link = timer->next;
+}
+
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data) {
+	struct AppTimer *t = fake_malloc(sizeof(struct AppTimer));
+	if (!t) return NULL;
+
+	t->id = next_timer_id++;
+	t->deadline = now_ms + timeout_ms;
+	t->callback = callback;
+	t->data = callback_data;
+	t->next = timers;
+	timers = t;
+	fake_stats.timer_registers++;
+
+	//handles are ids, so cancelling a timer that already fired is harmless
+	return (AppTimer*)(uintptr_t)t->id;
+}
+
+bool app_timer_reschedule(AppTimer *timer_handle, uint32_t new_timeout_ms) {
+	struct AppTimer *t = timer_find(timer_handle);
+	if (!t) return false;
+	t->deadline = now_ms + new_timeout_ms;
+	return true;
+}
+
+void app_timer_cancel(AppTimer *timer_handle) {
+	struct AppTimer *t = timer_find(timer_handle);
+	if (!t) return;
+	timer_unlink(t);
+	fake_free(t);
+	fake_stats.timer_cancels++;
+}
+
+static struct AppTimer *timer_next_due(void) {
+	struct AppTimer *due = NULL;
+	for (struct AppTimer *t = timers; t; t = t->next) {
+		if (!due || t->deadline < due->deadline || (t->deadline == due->deadline && t->id < due->id))
+			due = t;
+	}
+	return due;
+}
+
+//--- event services
+
+static TickHandler tick_handler;
+static TimeUnits tick_units = MINUTE_UNIT;
+static BluetoothConnectionHandler bluetooth_handler;
+static BatteryStateHandler battery_handler;
+static bool bluetooth_connected = true;
+static BatteryChargeState battery_state = {80, false, false};
+
+static uint64_t tick_period_ms(void) {
+	if (tick_units & SECOND_UNIT) return 1000;
+	if (tick_units & MINUTE_UNIT) return 60000;
+	if (tick_units & HOUR_UNIT) return 3600000;
+	return 86400000;
+}
+
+void tick_timer_service_subscribe(TimeUnits units, TickHandler handler) {
+	tick_units = units;
+	tick_handler = handler;
+	next_tick_ms = (now_ms / tick_period_ms() + 1) * tick_period_ms();
+}
+
+void tick_timer_service_unsubscribe(void) {
+	tick_handler = NULL;
+}
+
+static void fire_tick(void) {
+	time_t prev_t = (time_t)((now_ms - 1) / 1000), now_t = (time_t)(now_ms / 1000);
+	struct tm prev, cur;
+	localtime_r(&prev_t, &prev);
+	localtime_r(&now_t, &cur);
+
+	TimeUnits changed = 0;
+	if (prev.tm_sec != cur.tm_sec) changed |= SECOND_UNIT;
+	if (prev.tm_min != cur.tm_min) changed |= MINUTE_UNIT;
+	if (prev.tm_hour != cur.tm_hour) changed |= HOUR_UNIT;
+	if (prev.tm_mday != cur.tm_mday) changed |= DAY_UNIT;
+	if (prev.tm_mon != cur.tm_mon) changed |= MONTH_UNIT;
+	if (prev.tm_year != cur.tm_year) changed |= YEAR_UNIT;
+
+	if (changed & tick_units) {
+		fake_stats.ticks++;
+		tick_handler(&cur, changed);
+	}
+}
+
+void bluetooth_connection_service_subscribe(BluetoothConnectionHandler handler) {
+	bluetooth_handler = handler;
+}
+
+void bluetooth_connection_service_unsubscribe(void) {
+	bluetooth_handler = NULL;
+}
+
+bool bluetooth_connection_service_peek(void) {
+	return bluetooth_connected;
+}
+
+void fake_set_bluetooth(bool connected) {
+	if (connected == bluetooth_connected) return;
+	bluetooth_connected = connected;
+	if (bluetooth_handler) bluetooth_handler(connected);
+	fake_render();
+}
+
+void battery_state_service_subscribe(BatteryStateHandler handler) {
+	battery_handler = handler;
+}
+
+void battery_state_service_unsubscribe(void) {
+	battery_handler = NULL;
+}
+
+BatteryChargeState battery_state_service_peek(void) {
+	return battery_state;
+}
+
+void fake_set_battery(BatteryChargeState state) {
+	battery_state = state;
+	if (battery_handler) battery_handler(state);
+	fake_render();
+}
+
+void vibes_short_pulse(void) { fake_stats.vibes++; }
+void vibes_long_pulse(void) { fake_stats.vibes++; }
+void vibes_double_pulse(void) { fake_stats.vibes++; }
+
+//--- persistent storage
+
+typedef struct {
+	bool used;
+	uint32_t key;
+	uint16_t size;
+	uint8_t data[PERSIST_DATA_MAX_LENGTH];
+} PersistEntry;
+
+static PersistEntry persist_store[FAKE_MAX_PERSIST];
+
+static PersistEntry *persist_find(uint32_t key, bool create) {
+	PersistEntry *free_entry = NULL;
+	for (int i = 0; i < FAKE_MAX_PERSIST; i++) {
+		if (persist_store[i].used && persist_store[i].key == key) return &persist_store[i];
+		if (!persist_store[i].used && !free_entry) free_entry = &persist_store[i];
+	}
+	if (create && free_entry) {
+		free_entry->used = true;
+		free_entry->key = key;
+		free_entry->size = 0;
+		return free_entry;
+	}
+	return NULL;
+}
+
+bool persist_exists(const uint32_t key) {
+	return persist_find(key, false) != NULL;
+}
+
+int persist_get_size(const uint32_t key) {
+	PersistEntry *e = persist_find(key, false);
+	return e ? e->size : E_DOES_NOT_EXIST;
+}
+
+int32_t persist_read_int(const uint32_t key) {
+	int32_t value = 0;
+	persist_read_data(key, &value, sizeof(value));
+	return value;
+}
+
+int persist_read_data(const uint32_t key, void *buffer, const size_t buffer_size) {
+	PersistEntry *e = persist_find(key, false);
+	fake_stats.persist_reads++;
+	if (!e) return E_DOES_NOT_EXIST;
+
+	size_t n = e->size < buffer_size ? e->size : buffer_size;
+	memcpy(buffer, e->data, n);
+	return (int)n;
+}
+
+status_t persist_write_int(const uint32_t key, const int32_t value) {
+	int written = persist_write_data(key, &value, sizeof(value));
+	return written < 0 ? written : S_SUCCESS;
+}
+
+int persist_write_data(const uint32_t key, const void *data, const size_t size) {
+	if (size > PERSIST_DATA_MAX_LENGTH) return E_RANGE;
+
+	PersistEntry *e = persist_find(key, true);
+	if (!e) return E_OUT_OF_STORAGE;
+
+	memcpy(e->data, data, size);
+	e->size = (uint16_t)size;
+	fake_stats.persist_writes++;
+	fake_stats.persist_bytes_written += (uint32_t)size;
+	return (int)size;
+}
+
+status_t persist_delete(const uint32_t key) {
+	PersistEntry *e = persist_find(key, false);
+	if (!e) return E_DOES_NOT_EXIST;
+	e->used = false;
+	return S_SUCCESS;
+}
+
+void fake_persist_clear(void) {
+	memset(persist_store, 0, sizeof(persist_store));
+}
+
+//--- dictionaries
+
+struct __attribute__((__packed__)) Dictionary {
+	uint8_t count;
+	Tuple head[];
+};
+
+#define TUPLE_HEADER_SIZE ((uint32_t)sizeof(Tuple))
+
+uint32_t dict_calc_buffer_size(const uint8_t tuple_count, ...) {
+	uint32_t total = sizeof(Dictionary);
+	va_list args;
+	va_start(args, tuple_count);
+	for (int i = 0; i < tuple_count; i++) {
+		total += TUPLE_HEADER_SIZE + va_arg(args, uint32_t);
+	}
+	va_end(args);
+	return total;
+}
+
+DictionaryResult dict_write_begin(DictionaryIterator *iter, uint8_t * const buffer, const uint16_t size) {
+	if (!iter || !buffer || size < sizeof(Dictionary)) return DICT_INVALID_ARGS;
+
+	iter->dictionary = (Dictionary*)buffer;
+	iter->dictionary->count = 0;
+	iter->cursor = iter->dictionary->head;
+	iter->end = buffer + size;
+	return DICT_OK;
+}
+
+static DictionaryResult dict_write_tuple(DictionaryIterator *iter, uint32_t key, TupleType type, const void *data, uint16_t size) {
+	if (!iter || !iter->dictionary) return DICT_INVALID_ARGS;
+	if ((uint8_t*)iter->cursor + TUPLE_HEADER_SIZE + size > (uint8_t*)iter->end) return DICT_NOT_ENOUGH_STORAGE;
+
+	Tuple *t = iter->cursor;
+	t->key = key;
+	t->type = type;
+	t->length = size;
+	memcpy(t->value->data, data, size);
+	iter->dictionary->count++;
+	iter->cursor = (Tuple*)((uint8_t*)t + TUPLE_HEADER_SIZE + size);
+	return DICT_OK;
+}
+
+DictionaryResult dict_write_data(DictionaryIterator *iter, const uint32_t key, const uint8_t * const data, const uint16_t size) {
+	return dict_write_tuple(iter, key, TUPLE_BYTE_ARRAY, data, size);
+}
+
+DictionaryResult dict_write_cstring(DictionaryIterator *iter, const uint32_t key, const char * const cstring) {
+	return dict_write_tuple(iter, key, TUPLE_CSTRING, cstring, (uint16_t)(strlen(cstring) + 1));
+}
+
+DictionaryResult dict_write_int(DictionaryIterator *iter, const uint32_t key, const void *integer, const uint8_t width_bytes, const bool is_signed) {
+	if (width_bytes != 1 && width_bytes != 2 && width_bytes != 4) return DICT_INVALID_ARGS;
+	return dict_write_tuple(iter, key, is_signed ? TUPLE_INT : TUPLE_UINT, integer, width_bytes);
+}
+
+DictionaryResult dict_write_uint8(DictionaryIterator *iter, const uint32_t key, const uint8_t value) { return dict_write_int(iter, key, &value, 1, false); }
+DictionaryResult dict_write_uint16(DictionaryIterator *iter, const uint32_t key, const uint16_t value) { return dict_write_int(iter, key, &value, 2, false); }
+DictionaryResult dict_write_uint32(DictionaryIterator *iter, const uint32_t key, const uint32_t value) { return dict_write_int(iter, key, &value, 4, false); }
+DictionaryResult dict_write_int8(DictionaryIterator *iter, const uint32_t key, const int8_t value) { return dict_write_int(iter, key, &value, 1, true); }
+DictionaryResult dict_write_int16(DictionaryIterator *iter, const uint32_t key, const int16_t value) { return dict_write_int(iter, key, &value, 2, true); }
+DictionaryResult dict_write_int32(DictionaryIterator *iter, const uint32_t key, const int32_t value) { return dict_write_int(iter, key, &value, 4, true); }
+
+uint32_t dict_write_end(DictionaryIterator *iter) {
+	if (!iter || !iter->dictionary) return 0;
+	iter->end = iter->cursor;
+	return (uint32_t)((uint8_t*)iter->cursor - (uint8_t*)iter->dictionary);
+}
+
+Tuple *dict_read_begin_from_buffer(DictionaryIterator *iter, const uint8_t * const buffer, const uint16_t size) {
+	iter->dictionary = (Dictionary*)buffer;
+	iter->end = buffer + size;
+	return dict_read_first(iter);
+}
+
+Tuple *dict_read_first(DictionaryIterator *iter) {
+	iter->cursor = iter->dictionary->head;
+	if (iter->dictionary->count == 0 || (const uint8_t*)iter->cursor + TUPLE_HEADER_SIZE > (const uint8_t*)iter->end)
+		return NULL;
+	return iter->cursor;
+}
+
+Tuple *dict_read_next(DictionaryIterator *iter) {
+	if ((const uint8_t*)iter->cursor + TUPLE_HEADER_SIZE > (const uint8_t*)iter->end) return NULL;
+
+	Tuple *next = (Tuple*)((uint8_t*)iter->cursor + TUPLE_HEADER_SIZE + iter->cursor->length);
+	if ((const uint8_t*)next + TUPLE_HEADER_SIZE > (const uint8_t*)iter->end) {
+		iter->cursor = (Tuple*)iter->end;
+		return NULL;
+	}
+	iter->cursor = next;
+	return next;
+}
+
+Tuple *dict_find(const DictionaryIterator *iter, const uint32_t key) {
+	DictionaryIterator it = *iter;
+	for (Tuple *t = dict_read_first(&it); t; t = dict_read_next(&it)) {
+		if (t->key == key) return t;
+	}
+	return NULL;
+}
+
+//--- app messages
+
+typedef struct {
+	uint64_t due;
+	uint16_t size;
+	uint8_t *data;
+} InboundMessage;
+
+static uint8_t *inbox_buffer, *outbox_buffer;
+static uint32_t inbox_size, outbox_size;
+static void *message_context;
+static AppMessageInboxReceived inbox_received;
+static AppMessageInboxDropped inbox_dropped;
+static AppMessageOutboxSent outbox_sent;
+static AppMessageOutboxFailed outbox_failed;
+static DictionaryIterator outbox_iter;
+static enum {OUTBOX_IDLE, OUTBOX_WRITING, OUTBOX_IN_FLIGHT} outbox_state;
+static uint64_t outbox_ack_ms;
+static uint32_t outbox_latency_ms = 40;
+static int outbox_failures_pending;
+static FakeOutboxObserver outbox_observer;
+static void *outbox_observer_context;
+static InboundMessage inbound_queue[FAKE_MAX_INBOUND];
+static int inbound_count;
+
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound) {
+	if (inbox_buffer) return APP_MSG_INVALID_ARGS;
+
+	inbox_buffer = fake_malloc(size_inbound);
+	outbox_buffer = fake_malloc(size_outbound);
+	if (!inbox_buffer || !outbox_buffer) return APP_MSG_OUT_OF_MEMORY;
+	inbox_size = size_inbound;
+	outbox_size = size_outbound;
+	return APP_MSG_OK;
+}
+
+uint32_t app_message_inbox_size_maximum(void) { return FAKE_INBOX_MAXIMUM; }
+uint32_t app_message_outbox_size_maximum(void) { return FAKE_OUTBOX_MAXIMUM; }
+uint32_t fake_inbox_size(void) { return inbox_size; }
+uint32_t fake_outbox_size(void) { return outbox_size; }
+
+void *app_message_get_context(void) {
+	return message_context;
+}
+
+void *app_message_set_context(void *context) {
+	void *prev = message_context;
+	message_context = context;
+	return prev;
+}
+
+AppMessageInboxReceived app_message_register_inbox_received(AppMessageInboxReceived cb) {
+	AppMessageInboxReceived prev = inbox_received;
+	inbox_received = cb;
+	return prev;
+}
+
+AppMessageInboxDropped app_message_register_inbox_dropped(AppMessageInboxDropped cb) {
+	AppMessageInboxDropped prev = inbox_dropped;
+	inbox_dropped = cb;
+	return prev;
+}
+
+AppMessageOutboxSent app_message_register_outbox_sent(AppMessageOutboxSent cb) {
+	AppMessageOutboxSent prev = outbox_sent;
+	outbox_sent = cb;
+	return prev;
+}
+
+AppMessageOutboxFailed app_message_register_outbox_failed(AppMessageOutboxFailed cb) {
+	AppMessageOutboxFailed prev = outbox_failed;
+	outbox_failed = cb;
+	return prev;
+}
+
+void app_message_deregister_callbacks(void) {
+	inbox_received = NULL;
+	inbox_dropped = NULL;
+	outbox_sent = NULL;
+	outbox_failed = NULL;
+	fake_free(inbox_buffer);
+	fake_free(outbox_buffer);
+	inbox_buffer = outbox_buffer = NULL;
+	inbox_size = outbox_size = 0;
+	outbox_state = OUTBOX_IDLE;
+}
+
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator) {
+	if (!outbox_buffer) {
+		*iterator = NULL;
+		return APP_MSG_INVALID_ARGS;
+	}
+	if (outbox_state != OUTBOX_IDLE) {
+		//firmware leaves *iterator untouched; the fake clears it so callers that ignore the result don't crash
+		*iterator = NULL;
+		fake_stats.outbox_busy++;
+		return APP_MSG_BUSY;
+	}
+	dict_write_begin(&outbox_iter, outbox_buffer, (uint16_t)outbox_size);
+	outbox_state = OUTBOX_WRITING;
+	*iterator = &outbox_iter;
+	return APP_MSG_OK;
+}
+
+AppMessageResult app_message_outbox_send(void) {
+	if (outbox_state != OUTBOX_WRITING) return APP_MSG_INVALID_ARGS;
+
+	uint32_t size = dict_write_end(&outbox_iter);
+	outbox_state = OUTBOX_IN_FLIGHT;
+	outbox_ack_ms = now_ms + outbox_latency_ms;
+	fake_stats.msgs_out++;
+	fake_stats.bytes_out += size;
+	return APP_MSG_OK;
+}
+
+static void outbox_complete(void) {
+	DictionaryIterator iter;
+	uint32_t size = (uint32_t)((uint8_t*)outbox_iter.end - outbox_buffer);
+	dict_read_begin_from_buffer(&iter, outbox_buffer, (uint16_t)size);
+
+	outbox_state = OUTBOX_IDLE;
+	if (!bluetooth_connected || outbox_failures_pending > 0) {
+		if (bluetooth_connected) outbox_failures_pending--;
+		fake_stats.outbox_failed++;
+		if (outbox_failed) outbox_failed(&iter, bluetooth_connected ? APP_MSG_SEND_TIMEOUT : APP_MSG_NOT_CONNECTED, message_context);
+		return;
+	}
+	if (outbox_observer) {
+		DictionaryIterator observed = iter;
+		outbox_observer(&observed, outbox_observer_context);
+	}
+	if (outbox_sent) outbox_sent(&iter, message_context);
+}
+
+void fake_set_outbox_observer(FakeOutboxObserver observer, void *context) {
+	outbox_observer = observer;
+	outbox_observer_context = context;
+}
+
+void fake_set_outbox_latency(uint32_t ms) {
+	outbox_latency_ms = ms;
+}
+
+void fake_fail_next_sends(int count) {
+	outbox_failures_pending = count;
+}
+
+void fake_deliver(const uint8_t *buffer, uint16_t size) {
+	if (!inbox_buffer || !inbox_received) return;
+
+	if (size > inbox_size) {
+		fake_stats.msgs_dropped++;
+		if (inbox_dropped) inbox_dropped(APP_MSG_BUFFER_OVERFLOW, message_context);
+		return;
+	}
+	memcpy(inbox_buffer, buffer, size);
+
+	DictionaryIterator iter;
+	dict_read_begin_from_buffer(&iter, inbox_buffer, size);
+	fake_stats.msgs_in++;
+	fake_stats.bytes_in += size;
+	inbox_received(&iter, message_context);
+}
+
+void fake_queue_inbound(const uint8_t *buffer, uint16_t size, uint32_t delay_ms) {
+	if (inbound_count == FAKE_MAX_INBOUND) return;
+
+	InboundMessage *m = &inbound_queue[inbound_count++];
+	m->due = now_ms + delay_ms;
+	m->size = size;
+	m->data = malloc(size);
+	memcpy(m->data, buffer, size);
+}
+
+static int inbound_next_due(void) {
+	int best = -1;
+	for (int i = 0; i < inbound_count; i++) {
+		if (best < 0 || inbound_queue[i].due < inbound_queue[best].due) best = i;
+	}
+	return best;
+}
+
+static void inbound_deliver(int i) {
+	InboundMessage m = inbound_queue[i];
+	memmove(&inbound_queue[i], &inbound_queue[i + 1], (size_t)(inbound_count - i - 1) * sizeof(InboundMessage));
+	inbound_count--;
+	fake_deliver(m.data, m.size);
+	free(m.data);
+}
+
+//--- event loop
+
+void fake_set_event_loop(FakeEventLoopBody body) {
+	event_loop_body = body;
+}
+
+void app_event_loop(void) {
+	fake_render();
+	if (event_loop_body) event_loop_body();
+}
+
+void fake_advance_ms(uint32_t ms) {
+	uint64_t target = now_ms + ms;
+
+	for (;;) {
+		uint64_t next = target + 1;
+		struct AppTimer *timer = timer_next_due();
+		int inbound = inbound_next_due();
+
+		if (timer && timer->deadline < next) next = timer->deadline;
+		if (inbound >= 0 && inbound_queue[inbound].due < next) next = inbound_queue[inbound].due;
+		if (outbox_state == OUTBOX_IN_FLIGHT && outbox_ack_ms < next) next = outbox_ack_ms;
+		if (tick_handler && next_tick_ms < next) next = next_tick_ms;
+		if (scheduled_animations && now_ms + FAKE_FRAME_MS < next) next = now_ms + FAKE_FRAME_MS;
+		if (next > target) break;
+
+		if (next > now_ms) now_ms = next;
+
+		if (outbox_state == OUTBOX_IN_FLIGHT && outbox_ack_ms <= now_ms) {
+			outbox_complete();
+		} else if (inbound >= 0 && inbound_queue[inbound].due <= now_ms) {
+			inbound_deliver(inbound);
+		} else if (timer && timer->deadline <= now_ms) {
+			AppTimerCallback cb = timer->callback;
+			void *data = timer->data;
+			timer_unlink(timer);
+			fake_free(timer);
+			fake_stats.timer_wakeups++;
+			cb(data);
+		} else if (tick_handler && next_tick_ms <= now_ms) {
+			next_tick_ms += tick_period_ms();
+			fire_tick();
+		} else {
+			step_animations();
+		}
+		fake_render();
+	}
+	now_ms = target;
+}
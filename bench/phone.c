@@ -0,0 +1,241 @@
+#include "phone.h"
+#include "globals.h"
+#include "bmp_stream.h"
+
+PhoneStats phone_stats;
+
+static uint32_t reply_latency_ms;
+static uint8_t phone_session = 1;
+static uint8_t phone_gen[SM_NUM_SECTIONS] = {1, 1, 1, 1};
+static int phone_variant[SM_NUM_SECTIONS];
+
+static const char *conds[] = {"Partly Cloudy", "Light Rain"};
+static const char *temps[] = {"12\xc2\xb0", "9\xc2\xb0"};
+static const char *cal_times[] = {"Today 14:30", "Today 16:00"};
+static const char *cal_texts[] = {"Design review with the platform team", "Dentist"};
+static const char *artists[] = {"Boards of Canada", "Nils Frahm"};
+static const char *titles[] = {"Roygbiv", "Says"};
+
+static void write_section(DictionaryIterator *iter, int section, int v) {
+	switch (section) {
+		case SM_SECTION_WEATHER:
+			dict_write_cstring(iter, SM_WEATHER_COND_KEY, conds[v]);
+			dict_write_cstring(iter, SM_WEATHER_TEMP_KEY, temps[v]);
+			dict_write_uint8(iter, SM_WEATHER_ICON_KEY, (uint8_t)(3 - v));
+			break;
+		case SM_SECTION_CALENDAR:
+			dict_write_cstring(iter, SM_STATUS_CAL_TIME_KEY, cal_times[v]);
+			dict_write_cstring(iter, SM_STATUS_CAL_TEXT_KEY, cal_texts[v]);
+			break;
+		case SM_SECTION_MUSIC:
+			dict_write_cstring(iter, SM_STATUS_MUS_ARTIST_KEY, artists[v]);
+			dict_write_cstring(iter, SM_STATUS_MUS_TITLE_KEY, titles[v]);
+			break;
+		case SM_SECTION_BATTERY:
+			dict_write_uint8(iter, SM_COUNT_BATTERY_KEY, (uint8_t)(64 - v));
+			break;
+	}
+}
+
+uint16_t phone_build_status(uint8_t *buffer, uint16_t size, int variant) {
+	DictionaryIterator iter;
+	int v = variant & 1;
+
+	dict_write_begin(&iter, buffer, size);
+	write_section(&iter, SM_SECTION_WEATHER, v);
+	write_section(&iter, SM_SECTION_BATTERY, v);
+	write_section(&iter, SM_SECTION_CALENDAR, v);
+	write_section(&iter, SM_SECTION_MUSIC, v);
+	dict_write_int32(&iter, SM_STATUS_UPD_WEATHER_KEY, 900);
+	dict_write_int32(&iter, SM_STATUS_UPD_CAL_KEY, 600);
+	dict_write_int32(&iter, SM_SONG_LENGTH_KEY, 180);
+	return (uint16_t)dict_write_end(&iter);
+}
+
+uint16_t phone_build_section(uint8_t *buffer, uint16_t size, int section, int variant) {
+	DictionaryIterator iter;
+
+	dict_write_begin(&iter, buffer, size);
+	write_section(&iter, section, variant & 1);
+	return (uint16_t)dict_write_end(&iter);
+}
+
+static void write_generations(DictionaryIterator *iter, int section, int age) {
+	uint8_t gen[SM_STATUS_GEN_SIZE] = {phone_session};
+
+	memcpy(&gen[1], phone_gen, sizeof(phone_gen));
+	if (section >= 0)
+		gen[1 + section] -= (uint8_t)age;
+	dict_write_data(iter, SM_STATUS_GEN_KEY, gen, sizeof(gen));
+}
+
+uint16_t phone_build_reply(uint8_t *buffer, uint16_t size, int section, int age) {
+	DictionaryIterator iter;
+
+	dict_write_begin(&iter, buffer, size);
+	write_section(&iter, section, phone_variant[section] ^ (age & 1));
+	write_generations(&iter, section, age);
+	return (uint16_t)dict_write_end(&iter);
+}
+
+void phone_change_section(int section) {
+	phone_variant[section] ^= 1;
+	if (++phone_gen[section] == 0)
+		phone_gen[section] = 1;
+}
+
+void phone_restart(void) {
+	if (++phone_session == 0)
+		phone_session = 1;
+	for (int i = 0; i < SM_NUM_SECTIONS; i++) {
+		phone_gen[i] = 1;
+		phone_variant[i] ^= 1;
+	}
+}
+
+//answers SM_SCREEN_ENTER_KEY and the per-section refresh commands with the
+//sections whose generation differs from the one the watch echoed
+static void on_watch_message(DictionaryIterator *received, void *context) {
+	uint8_t known[SM_NUM_SECTIONS] = {0};
+	bool wanted[SM_NUM_SECTIONS] = {false};
+	bool weather_interval = false, cal_interval = false, song_interval = false;
+
+	//generations from another session say nothing about what the watch has
+	Tuple *t = dict_find(received, SM_STATUS_GEN_KEY);
+	const uint8_t *echo = t ? t->value->data : NULL;
+	if (echo && t->length == SM_STATUS_GEN_SIZE && echo[0] == phone_session)
+		memcpy(known, &echo[1], sizeof(known));
+
+	if (dict_find(received, SM_SCREEN_ENTER_KEY)) {
+		for (int i = 0; i < SM_NUM_SECTIONS; i++) wanted[i] = true;
+		weather_interval = cal_interval = song_interval = true;
+	}
+	if (dict_find(received, SM_STATUS_UPD_WEATHER_KEY)) {
+		wanted[SM_SECTION_WEATHER] = wanted[SM_SECTION_BATTERY] = true;
+		weather_interval = true;
+	}
+	if (dict_find(received, SM_STATUS_UPD_CAL_KEY)) {
+		wanted[SM_SECTION_CALENDAR] = true;
+		cal_interval = true;
+	}
+	if (dict_find(received, SM_SONG_LENGTH_KEY)) {
+		wanted[SM_SECTION_MUSIC] = true;
+		song_interval = true;
+	}
+	if (!weather_interval && !cal_interval && !song_interval)
+		return;
+
+	phone_stats.requests++;
+
+	uint8_t buffer[512];
+	DictionaryIterator iter;
+	dict_write_begin(&iter, buffer, sizeof(buffer));
+	for (int i = 0; i < SM_NUM_SECTIONS; i++) {
+		if (!wanted[i]) continue;
+		if (known[i] == phone_gen[i]) {
+			phone_stats.sections_skipped++;
+			continue;
+		}
+		write_section(&iter, i, phone_variant[i]);
+		phone_stats.sections_sent++;
+	}
+	write_generations(&iter, -1, 0);
+	if (weather_interval) dict_write_int32(&iter, SM_STATUS_UPD_WEATHER_KEY, 900);
+	if (cal_interval) dict_write_int32(&iter, SM_STATUS_UPD_CAL_KEY, 600);
+	if (song_interval) dict_write_int32(&iter, SM_SONG_LENGTH_KEY, 180);
+
+	phone_stats.replies++;
+	fake_queue_inbound(buffer, (uint16_t)dict_write_end(&iter), reply_latency_ms);
+}
+
+void phone_attach(uint32_t latency_ms) {
+	reply_latency_ms = latency_ms;
+	fake_set_outbox_observer(on_watch_message, NULL);
+}
+
+void phone_detach(void) {
+	fake_set_outbox_observer(NULL, NULL);
+}
+
+//horizontal bands with a diagonal stripe, so both runs and literals show up
+uint8_t phone_bitmap_byte(int width, int row, int col) {
+	if ((row / 8) % 2 == 0)
+		return (row + col) % 9 == 0 ? 0x0f : 0x00;
+	return 0xff;
+}
+
+#define BMP_CHUNK_MAX	128
+
+static uint8_t chunk[BMP_CHUNK_MAX];
+static int chunk_len, chunks_sent;
+static uint8_t chunk_seq;
+
+static void chunk_flush(bool last) {
+	uint8_t buffer[BMP_CHUNK_MAX + 16];
+	DictionaryIterator iter;
+
+	if (last)
+		chunk[0] |= BMP_CHUNK_END;
+	dict_write_begin(&iter, buffer, sizeof(buffer));
+	dict_write_data(&iter, SM_STREAMING_BMP_KEY, chunk, chunk_len);
+	fake_deliver(buffer, (uint16_t)dict_write_end(&iter));
+	chunks_sent++;
+
+	chunk[0] = 0;
+	chunk[1] = ++chunk_seq;
+	chunk_len = BMP_CHUNK_HEADER;
+}
+
+static void chunk_put(uint8_t b, uint32_t interval_ms) {
+	if (chunk_len == BMP_CHUNK_MAX) {
+		chunk_flush(false);
+		fake_advance_ms(interval_ms);
+	}
+	chunk[chunk_len++] = b;
+}
+
+int phone_send_bitmap(int width, int height, int encoding, uint32_t interval_ms) {
+	static uint8_t raw[32 * 255];		//phone memory, kept off the watch heap
+	int row_bytes = (width + 7) / 8, total = row_bytes * height;
+
+	for (int r = 0; r < height; r++)
+		for (int c = 0; c < row_bytes; c++)
+			raw[r * row_bytes + c] = phone_bitmap_byte(width, r, c);
+
+	chunks_sent = 0;
+	chunk_seq = 0;
+	chunk[0] = BMP_CHUNK_START;
+	chunk[1] = 0;
+	chunk[2] = (uint8_t)width;
+	chunk[3] = (uint8_t)height;
+	chunk[4] = (uint8_t)encoding;
+	chunk_len = BMP_START_HEADER;
+
+	if (encoding == BMP_RAW) {
+		for (int i = 0; i < total; i++)
+			chunk_put(raw[i], interval_ms);
+	} else {
+		//PackBits: runs of 3+ become a repeat, everything else literals of up to 128
+		int i = 0;
+		while (i < total) {
+			int run = 1;
+			while (i + run < total && run < 128 && raw[i + run] == raw[i]) run++;
+			if (run >= 3) {
+				chunk_put((uint8_t)(257 - run), interval_ms);
+				chunk_put(raw[i], interval_ms);
+				i += run;
+				continue;
+			}
+			int lit = 1;
+			while (i + lit < total && lit < 128
+			       && !(i + lit + 2 < total && raw[i + lit] == raw[i + lit + 1] && raw[i + lit] == raw[i + lit + 2]))
+				lit++;
+			chunk_put((uint8_t)(lit - 1), interval_ms);
+			for (int k = 0; k < lit; k++)
+				chunk_put(raw[i + k], interval_ms);
+			i += lit;
+		}
+	}
+	chunk_flush(true);
+	return chunks_sent;
+}
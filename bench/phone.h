@@ -0,0 +1,45 @@
+#ifndef _phone_h
+#define _phone_h
+
+//stand-in for the Smartwatch+ side of the status screen protocol
+
+#include "fake.h"
+
+typedef struct {
+	uint32_t requests;
+	uint32_t replies;
+	uint32_t sections_sent;
+	uint32_t sections_skipped;
+} PhoneStats;
+
+extern PhoneStats phone_stats;
+
+//hook the fake outbox so status requests from the watch get answered after latency_ms
+void phone_attach(uint32_t latency_ms);
+void phone_detach(void);
+
+//switch a section to another set of values and bump its generation
+void phone_change_section(int section);
+
+//the phone app restarts: a new session, every section back at generation 1
+//with the other set of values
+void phone_restart(void);
+
+//full status payload without generations, like a phone that predates delta sync
+uint16_t phone_build_status(uint8_t *buffer, uint16_t size, int variant);
+
+//one section on its own, the way some phones resync after a reconnect
+uint16_t phone_build_section(uint8_t *buffer, uint16_t size, int section, int variant);
+
+//the reply the phone sends for section, age generations back; the older
+//generations carried the other set of values
+uint16_t phone_build_reply(uint8_t *buffer, uint16_t size, int section, int age);
+
+//test image byte at row, col of a width pixel wide 1-bit image
+uint8_t phone_bitmap_byte(int width, int row, int col);
+
+//push that image over SM_STREAMING_BMP_KEY, one chunk every interval_ms;
+//returns the number of chunks
+int phone_send_bitmap(int width, int height, int encoding, uint32_t interval_ms);
+
+#endif
@@ -0,0 +1,232 @@
+//feeds a trace recorded with SM_TRACE (see src/trace.h) back through the app's
+//handlers on the mock clock and reports what the app spent on it. with a
+//baseline it fails when a count went up, or CPU time grew past the tolerance.
+//
+//  smreplay TRACE [-s speed] [-b baseline] [-w baseline] [-t tolerance]
+//
+//speed 0 (the default) replays as fast as the host goes, 1 at the recorded
+//pace, N at N times that. -w writes the numbers of this run as the baseline.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "fake.h"
+#include "trace.h"
+
+int pebble_app_main(void);
+
+typedef struct {
+	const char *name;
+	uint64_t value;
+	bool timing;		//host dependent, checked against the tolerance instead of exactly
+} Metric;
+
+enum {CPU_US, FRAMES, LAYER_DRAWS, TIMER_WAKEUPS, MSGS_OUT, BYTES_OUT, ALLOCS, HEAP_PEAK, NUM_METRICS};
+
+static Metric metrics[NUM_METRICS] = {
+	[CPU_US]		= {"cpu_us", 0, true},
+	[FRAMES]		= {"frames", 0, false},
+	[LAYER_DRAWS]	= {"layer_draws", 0, false},
+	[TIMER_WAKEUPS]	= {"timer_wakeups", 0, false},
+	[MSGS_OUT]		= {"msgs_out", 0, false},
+	[BYTES_OUT]		= {"bytes_out", 0, false},
+	[ALLOCS]		= {"allocs", 0, false},
+	[HEAP_PEAK]		= {"heap_peak", 0, false},
+};
+
+#define TRACE_MAX_SIZE	(4 * 1024 * 1024)
+
+//timings this close to the baseline are host noise, whatever the tolerance
+#define CPU_SLACK_US	2000
+
+static uint8_t trace[TRACE_MAX_SIZE];		//host memory, malloc here would come off the watch heap
+static size_t trace_size;
+static double speed = 0;
+static uint32_t records, recorded_sends, trace_ms;
+
+
+static uint32_t get_le(const uint8_t *p, int bytes) {
+	uint32_t value = 0;
+	for (int i = bytes - 1; i >= 0; i--)
+		value = (value << 8) | p[i];
+	return value;
+}
+
+static uint64_t cpu_us(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static bool load(const char *path) {
+	FILE *f = fopen(path, "rb");
+
+	if (!f) {
+		perror(path);
+		return false;
+	}
+	trace_size = fread(trace, 1, sizeof(trace), f);
+	if (!feof(f))
+		fprintf(stderr, "%s: only the first %d bytes are replayed\n", path, TRACE_MAX_SIZE);
+	fclose(f);
+
+	if (trace_size < TRACE_HEADER_SIZE || memcmp(trace, TRACE_MAGIC, 4) != 0) {
+		fprintf(stderr, "%s: not a trace\n", path);
+		return false;
+	}
+	return true;
+}
+
+static void replay(void) {
+	uint64_t origin = fake_now_ms();
+	uint64_t cpu_start = cpu_us();
+	size_t pos = TRACE_HEADER_SIZE;
+
+	fake_stats_reset();
+	while (pos + TRACE_RECORD_SIZE <= trace_size) {
+		uint32_t at = get_le(&trace[pos], 4);
+		uint8_t kind = trace[pos + 4];
+		uint16_t length = (uint16_t)get_le(&trace[pos + 5], 2);
+		const uint8_t *payload = &trace[pos + TRACE_RECORD_SIZE];
+
+		if (pos + TRACE_RECORD_SIZE + length > trace_size) {
+			fprintf(stderr, "trace truncated at byte %zu\n", pos);
+			break;
+		}
+		pos += TRACE_RECORD_SIZE + length;
+
+		if (origin + at > fake_now_ms()) {
+			uint32_t gap = (uint32_t)(origin + at - fake_now_ms());
+			if (speed > 0)
+				usleep((useconds_t)(gap * 1000 / speed));
+			fake_advance_ms(gap);
+		}
+
+		switch (kind) {
+			case TRACE_IN:
+				fake_deliver(payload, length);
+				break;
+			case TRACE_OUT:
+				recorded_sends++;
+				break;
+			case TRACE_CONNECTION:
+				fake_set_bluetooth(payload[0] != 0);
+				break;
+			case TRACE_BUTTON:
+				fake_click((ButtonId)payload[0]);
+				break;
+		}
+		//the firmware draws after every event it hands the app
+		fake_render();
+		records++;
+		trace_ms = at;
+	}
+	//let the last message's timers and redraws run out
+	fake_advance_ms(1000);
+
+	metrics[CPU_US].value = cpu_us() - cpu_start;
+	metrics[FRAMES].value = fake_stats.frames;
+	metrics[LAYER_DRAWS].value = fake_stats.layer_draws;
+	metrics[TIMER_WAKEUPS].value = fake_stats.timer_wakeups;
+	metrics[MSGS_OUT].value = fake_stats.msgs_out;
+	metrics[BYTES_OUT].value = fake_stats.bytes_out;
+	metrics[ALLOCS].value = fake_stats.allocs;
+	metrics[HEAP_PEAK].value = fake_stats.heap_peak;
+}
+
+static bool write_baseline(const char *path) {
+	FILE *f = fopen(path, "w");
+
+	if (!f) {
+		perror(path);
+		return false;
+	}
+	for (int i = 0; i < NUM_METRICS; i++)
+		fprintf(f, "%s %llu\n", metrics[i].name, (unsigned long long)metrics[i].value);
+	fclose(f);
+	return true;
+}
+
+//returns the number of metrics that got worse
+static int check_baseline(const char *path, double tolerance) {
+	FILE *f = fopen(path, "r");
+	char name[32];
+	unsigned long long expected;
+	int failed = 0;
+
+	if (!f) {
+		perror(path);
+		return 1;
+	}
+	printf("%-16s %12s %12s\n", "metric", "replay", "baseline");
+	while (fscanf(f, "%31s %llu", name, &expected) == 2) {
+		for (int i = 0; i < NUM_METRICS; i++) {
+			if (strcmp(name, metrics[i].name) != 0)
+				continue;
+			bool worse = metrics[i].timing
+				? metrics[i].value > expected * tolerance && metrics[i].value > expected + CPU_SLACK_US
+				: metrics[i].value > expected;
+			printf("%-16s %12llu %12llu%s\n", name, (unsigned long long)metrics[i].value, expected, worse ? "  REGRESSION" : "");
+			failed += worse;
+		}
+	}
+	fclose(f);
+	return failed;
+}
+
+static void usage(void) {
+	fprintf(stderr, "usage: smreplay TRACE [-s speed] [-b baseline] [-w baseline] [-t tolerance]\n");
+	exit(2);
+}
+
+int main(int argc, char **argv) {
+	const char *path = NULL, *baseline = NULL, *write = NULL;
+	double tolerance = 3.0;
+	int failed = 0;
+
+	for (int i = 1; i < argc; i++) {
+		if (argv[i][0] != '-') {
+			path = argv[i];
+			continue;
+		}
+		if (i + 1 == argc)
+			usage();
+		switch (argv[i][1]) {
+			case 's': speed = atof(argv[++i]); break;
+			case 'b': baseline = argv[++i]; break;
+			case 'w': write = argv[++i]; break;
+			case 't': tolerance = atof(argv[++i]); break;
+			default: usage();
+		}
+	}
+	if (path == NULL || !load(path))
+		usage();
+
+	setenv("TZ", "UTC", 1);
+	tzset();
+
+	//same wall clock and connection state the trace starts from
+	fake_set_time((time_t)get_le(&trace[4], 4));
+	if (trace_size >= TRACE_HEADER_SIZE + TRACE_RECORD_SIZE + 1 && trace[TRACE_HEADER_SIZE + 4] == TRACE_CONNECTION)
+		fake_set_bluetooth(trace[TRACE_HEADER_SIZE + TRACE_RECORD_SIZE] != 0);
+
+	fake_set_event_loop(replay);
+	pebble_app_main();
+
+	printf("%s: %u records over %.1f s, %u commands sent when recorded\n",
+	       path, records, trace_ms / 1000.0, recorded_sends);
+
+	if (write && !write_baseline(write))
+		return 1;
+	if (baseline) {
+		failed = check_baseline(baseline, tolerance);
+	} else {
+		for (int i = 0; i < NUM_METRICS; i++)
+			printf("%-16s %12llu\n", metrics[i].name, (unsigned long long)metrics[i].value);
+	}
+	if (failed)
+		printf("%d metrics regressed\n", failed);
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,148 @@
+#include <pebble.h>
+#include "bmp_stream.h"
+
+static GSize max_size;
+static GBitmap *bitmap = NULL;
+static BmpStreamStats stats;
+
+//transfer in progress
+static bool receiving;
+static uint8_t next_seq;
+static uint8_t encoding;
+static uint16_t src_row_bytes, src_height;
+static uint16_t row, col;
+
+//PackBits state carried across chunks
+static uint8_t literal_left;
+static uint16_t repeat_left;
+static bool want_repeat_value;
+
+
+static void put_byte(uint8_t value) {
+	if (row >= src_height)
+		return;
+
+	if (row < bitmap->bounds.size.h && col < bitmap->row_size_bytes && col * 8 < bitmap->bounds.size.w)
+		((uint8_t *)bitmap->addr)[row * bitmap->row_size_bytes + col] = value;
+
+	if (++col == src_row_bytes) {
+		col = 0;
+		row++;
+	}
+}
+
+static void decode_rle(const uint8_t *data, size_t length) {
+	for (size_t i = 0; i < length; i++) {
+		uint8_t b = data[i];
+
+		if (literal_left > 0) {
+			literal_left--;
+			put_byte(b);
+		} else if (want_repeat_value) {
+			want_repeat_value = false;
+			while (repeat_left > 0) {
+				repeat_left--;
+				put_byte(b);
+			}
+		} else if (b < 128) {
+			literal_left = b + 1;
+		} else {
+			repeat_left = 257 - b;
+			want_repeat_value = true;
+		}
+	}
+}
+
+static bool start(const uint8_t *data, size_t length) {
+	if (length < BMP_START_HEADER || data[2] == 0 || data[3] == 0 || data[4] > BMP_RLE)
+		return false;
+
+	if (bitmap == NULL) {
+		bitmap = gbitmap_create_blank(max_size);
+		if (bitmap == NULL)
+			return false;
+	}
+	memset(bitmap->addr, 0, bitmap->row_size_bytes * bitmap->bounds.size.h);
+
+	src_row_bytes = (data[2] + 7) / 8;
+	src_height = data[3];
+	encoding = data[4];
+	row = col = 0;
+	literal_left = 0;
+	repeat_left = 0;
+	want_repeat_value = false;
+	receiving = true;
+	return true;
+}
+
+
+bool bmp_stream_chunk(const uint8_t *data, size_t length) {
+	size_t header = BMP_CHUNK_HEADER;
+	uint16_t rows_before;
+
+	if (length < BMP_CHUNK_HEADER) {
+		stats.errors++;
+		return false;
+	}
+
+	if (data[0] & BMP_CHUNK_START) {
+		if (data[1] != 0 || !start(data, length)) {
+			receiving = false;
+			stats.errors++;
+			return false;
+		}
+		header = BMP_START_HEADER;
+		next_seq = 0;
+	} else if (!receiving) {
+		stats.errors++;
+		return false;
+	} else if (data[1] == (uint8_t)(next_seq - 1)) {
+		//the phone resent a chunk we already have
+		return false;
+	} else if (data[1] != next_seq) {
+		//lost a chunk, wait for the next image rather than show garbage
+		APP_LOG(APP_LOG_LEVEL_DEBUG, "bitmap chunk %d, expected %d", data[1], next_seq);
+		receiving = false;
+		stats.errors++;
+		return false;
+	}
+
+	next_seq++;
+	stats.chunks++;
+	stats.bytes += length;
+	rows_before = row;
+
+	if (encoding == BMP_RLE) {
+		decode_rle(data + header, length - header);
+	} else {
+		for (size_t i = header; i < length; i++)
+			put_byte(data[i]);
+	}
+
+	if ((data[0] & BMP_CHUNK_END) || row >= src_height) {
+		receiving = false;
+		stats.images++;
+	}
+
+	return row != rows_before && rows_before < bitmap->bounds.size.h;
+}
+
+GBitmap *bmp_stream_bitmap(void) {
+	return bitmap;
+}
+
+const BmpStreamStats *bmp_stream_get_stats(void) {
+	return &stats;
+}
+
+void bmp_stream_init(GSize size) {
+	max_size = size;
+	receiving = false;
+}
+
+void bmp_stream_deinit(void) {
+	if (bitmap != NULL)
+		gbitmap_destroy(bitmap);
+	bitmap = NULL;
+	receiving = false;
+}
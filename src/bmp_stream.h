@@ -0,0 +1,45 @@
+#ifndef _bmp_stream_h
+#define _bmp_stream_h
+
+#include <pebble.h>
+
+//receives 1-bit images from SM_STREAMING_BMP_KEY in sequenced chunks and
+//decodes them straight into one bitmap that is allocated on the first image
+//and reused for every later one, whatever its size.
+//
+//chunk layout:
+//  [0] flags   BMP_CHUNK_START, BMP_CHUNK_END
+//  [1] sequence number, 0 on the start chunk, +1 per chunk
+//  start chunk only:
+//  [2] width  [3] height  [4] encoding (BMP_RAW or BMP_RLE)
+//  then payload: rows of (width + 7) / 8 bytes, pixel x in bit x % 8 of byte
+//  x / 8 like GBitmap. BMP_RLE packs that byte stream PackBits style:
+//  n < 128 is followed by n + 1 literal bytes, n >= 128 by one byte repeated
+//  257 - n times. runs and literals may cross chunk boundaries.
+//
+//pixels outside the preallocated size are dropped.
+
+#define BMP_CHUNK_START		0x1
+#define BMP_CHUNK_END		0x2
+#define BMP_START_HEADER	5
+#define BMP_CHUNK_HEADER	2
+
+enum {BMP_RAW, BMP_RLE};
+
+typedef struct {
+	uint32_t chunks;
+	uint32_t bytes;
+	uint32_t images;		//transfers completed
+	uint32_t errors;		//chunks dropped for a bad sequence or header
+} BmpStreamStats;
+
+void bmp_stream_init(GSize max_size);
+void bmp_stream_deinit(void);
+
+//feed one chunk; returns true when more rows became visible
+bool bmp_stream_chunk(const uint8_t *data, size_t length);
+
+GBitmap *bmp_stream_bitmap(void);
+const BmpStreamStats *bmp_stream_get_stats(void);
+
+#endif
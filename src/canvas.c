@@ -0,0 +1,195 @@
+#include <pebble.h>
+#include "canvas.h"
+#include "debug_stats.h"
+
+typedef struct {
+	uint8_t op;
+	uint8_t style;
+	GRect box;					//rect, text box, bitmap position; line start and end in origin/size
+	union {
+		const char *text;
+		GBitmap *bitmap;
+	};
+	GFont font;
+} CanvasCommand;
+
+//font index used by CANVAS_TEXT
+static const char *const FONT_KEYS[] = {
+	FONT_KEY_GOTHIC_14,
+	FONT_KEY_GOTHIC_14_BOLD,
+	FONT_KEY_GOTHIC_18,
+	FONT_KEY_GOTHIC_18_BOLD,
+	FONT_KEY_GOTHIC_24_BOLD,
+	FONT_KEY_GOTHIC_28
+};
+#define NUM_FONTS	(sizeof(FONT_KEYS) / sizeof(FONT_KEYS[0]))
+
+static const uint8_t ARG_BYTES[] = {
+	[CANVAS_RECT] = 5,
+	[CANVAS_LINE] = 5,
+	[CANVAS_TEXT] = 7,
+	[CANVAS_BITMAP] = 3
+};
+
+//the raw list is kept: it is compared against new ones and texts point into it
+static uint8_t list[CANVAS_MAX_LIST];
+static size_t list_length;
+
+static CanvasCommand commands[CANVAS_MAX_COMMANDS];
+static int num_commands;
+
+static CanvasBitmapRef resolve_bitmap;
+static CanvasStats stats;
+
+
+//returns the number of commands or -1; texts still hold string indices here
+static int parse_commands(const uint8_t *data, size_t length, CanvasCommand *out, size_t *pool) {
+	size_t pos = 0;
+	int n = 0;
+
+	while (pos < length && data[pos] != CANVAS_END) {
+		uint8_t op = data[pos++];
+		const uint8_t *a = &data[pos];
+
+		if (op > CANVAS_BITMAP || pos + ARG_BYTES[op] > length || n == CANVAS_MAX_COMMANDS)
+			return -1;
+		pos += ARG_BYTES[op];
+
+		CanvasCommand *c = &out[n++];
+		c->op = op;
+		switch (op) {
+			case CANVAS_RECT:
+			case CANVAS_LINE:
+				c->box = GRect(a[0], a[1], a[2], a[3]);
+				c->style = a[4];
+				break;
+			case CANVAS_TEXT:
+				if (a[5] >= NUM_FONTS)
+					return -1;
+				c->box = GRect(a[0], a[1], a[2], a[3]);
+				c->style = a[4];
+				c->font = fonts_get_system_font(FONT_KEYS[a[5]]);
+				c->text = (const char *)(uintptr_t)a[6];
+				break;
+			case CANVAS_BITMAP:
+				c->bitmap = resolve_bitmap ? resolve_bitmap(a[2]) : NULL;
+				if (c->bitmap == NULL)
+					return -1;
+				c->box = GRect(a[0], a[1], c->bitmap->bounds.size.w, c->bitmap->bounds.size.h);
+				break;
+		}
+	}
+
+	if (pos >= length)
+		return -1;
+	*pool = pos + 1;
+	return n;
+}
+
+//points each text command at its string in the pool
+static bool resolve_texts(CanvasCommand *cmds, int n, const uint8_t *data, size_t length, size_t pool) {
+	const char *strings[CANVAS_MAX_COMMANDS];
+	int num_strings = 0;
+
+	while (pool < length && num_strings < CANVAS_MAX_COMMANDS) {
+		const char *s = (const char *)&data[pool];
+		const char *nul = memchr(s, '\0', length - pool);
+		if (nul == NULL)
+			break;					//last string is not terminated
+		size_t len = (size_t)(nul - s);
+		strings[num_strings++] = s;
+		pool += len + 1;
+	}
+
+	for (int i = 0; i < n; i++) {
+		if (cmds[i].op != CANVAS_TEXT)
+			continue;
+		uintptr_t ref = (uintptr_t)cmds[i].text;
+		if (ref >= (uintptr_t)num_strings)
+			return false;
+		cmds[i].text = strings[ref];
+	}
+	return true;
+}
+
+
+bool canvas_set_list(const uint8_t *data, size_t length) {
+	size_t pool;
+	int n;
+
+	stats.lists++;
+	if (length == list_length && memcmp(data, list, length) == 0)
+		return false;
+
+	if (length > CANVAS_MAX_LIST) {
+		stats.rejected++;
+		return false;
+	}
+
+	//parse aside so a malformed list leaves the current one on screen
+	CanvasCommand parsed[CANVAS_MAX_COMMANDS];
+
+	n = parse_commands(data, length, parsed, &pool);
+	if (n < 0 || !resolve_texts(parsed, n, data, length, pool)) {
+		stats.rejected++;
+		return false;
+	}
+
+	//texts point into the tuple, move them over to the kept copy
+	memcpy(list, data, length);
+	list_length = length;
+	for (int i = 0; i < n; i++) {
+		if (parsed[i].op == CANVAS_TEXT)
+			parsed[i].text = (const char *)list + ((const uint8_t *)parsed[i].text - data);
+	}
+	memcpy(commands, parsed, n * sizeof(CanvasCommand));
+	num_commands = n;
+
+	stats.parses++;
+	return true;
+}
+
+void canvas_update_proc(Layer *layer, GContext *ctx) {
+	DEBUG_BEGIN(start);
+
+	for (int i = 0; i < num_commands; i++) {
+		const CanvasCommand *c = &commands[i];
+		GColor color = (c->style & CANVAS_WHITE) ? GColorWhite : GColorBlack;
+
+		switch (c->op) {
+			case CANVAS_RECT:
+				if (c->style & CANVAS_FILL) {
+					graphics_context_set_fill_color(ctx, color);
+					graphics_fill_rect(ctx, c->box, 0, GCornerNone);
+				} else {
+					graphics_context_set_stroke_color(ctx, color);
+					graphics_draw_rect(ctx, c->box);
+				}
+				break;
+			case CANVAS_LINE:
+				graphics_context_set_stroke_color(ctx, color);
+				graphics_draw_line(ctx, c->box.origin, GPoint(c->box.size.w, c->box.size.h));
+				break;
+			case CANVAS_TEXT:
+				graphics_context_set_text_color(ctx, color);
+				graphics_draw_text(ctx, c->text, c->font, c->box, GTextOverflowModeTrailingEllipsis,
+					(GTextAlignment)((c->style & CANVAS_ALIGN_MASK) >> CANVAS_ALIGN_SHIFT), NULL);
+				break;
+			case CANVAS_BITMAP:
+				graphics_draw_bitmap_in_rect(ctx, c->bitmap, c->box);
+				break;
+		}
+	}
+
+	DEBUG_END(DEBUG_DRAW_CANVAS, start);
+}
+
+const CanvasStats *canvas_get_stats(void) {
+	return &stats;
+}
+
+void canvas_init(CanvasBitmapRef bitmap_ref) {
+	resolve_bitmap = bitmap_ref;
+	list_length = 0;
+	num_commands = 0;
+}
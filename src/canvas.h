@@ -0,0 +1,46 @@
+#ifndef _canvas_h
+#define _canvas_h
+
+#include <pebble.h>
+
+//draws a panel the phone describes as a list of commands (SM_CANVAS_DICT_KEY).
+//the list is parsed once when it arrives; drawing just walks the parsed array.
+//
+//list: commands, a CANVAS_END byte, then the NUL separated strings texts refer to
+//  CANVAS_RECT    x y w h style
+//  CANVAS_LINE    x0 y0 x1 y1 style
+//  CANVAS_TEXT    x y w h style font string
+//  CANVAS_BITMAP  x y bitmap
+//coordinates are unsigned bytes in the panel. style: CANVAS_WHITE, CANVAS_FILL,
+//and for text the alignment in CANVAS_ALIGN_MASK (GTextAlignment << 2).
+
+enum {CANVAS_END, CANVAS_RECT, CANVAS_LINE, CANVAS_TEXT, CANVAS_BITMAP};
+
+#define CANVAS_WHITE		0x1
+#define CANVAS_FILL			0x2
+#define CANVAS_ALIGN_SHIFT	2
+#define CANVAS_ALIGN_MASK	(0x3 << CANVAS_ALIGN_SHIFT)
+
+#define CANVAS_MAX_LIST		128
+#define CANVAS_MAX_COMMANDS	16
+
+//bitmap commands carry an index the app resolves, e.g. a weather icon
+typedef GBitmap *(*CanvasBitmapRef)(uint8_t ref);
+
+typedef struct {
+	uint32_t lists;			//lists received
+	uint32_t parses;		//lists that differed from the one shown
+	uint32_t rejected;		//malformed lists
+} CanvasStats;
+
+void canvas_init(CanvasBitmapRef bitmap_ref);
+
+//parses a new list unless it is the one already shown; returns true when the
+//drawing changed. a malformed list keeps the previous one
+bool canvas_set_list(const uint8_t *data, size_t length);
+
+void canvas_update_proc(Layer *layer, GContext *ctx);
+
+const CanvasStats *canvas_get_stats(void);
+
+#endif
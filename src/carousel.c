@@ -0,0 +1,157 @@
+#include <pebble.h>
+#include "carousel.h"
+
+static Layer *parent_layer;
+static GRect slot;
+
+static Layer *panels[CAROUSEL_MAX_PANELS];
+static bool enabled[CAROUSEL_MAX_PANELS];
+static int num_panels;
+
+static int active, target, outgoing = -1;
+
+//created once, subject and values are rewritten for each slide
+static PropertyAnimation *ani_out, *ani_in;
+
+static CarouselShownHandler shown_handler;
+static bool animated = true;
+
+static CarouselStats stats;
+
+
+static GRect slot_offset(int16_t dx) {
+	return GRect(slot.origin.x + dx, slot.origin.y, slot.size.w, slot.size.h);
+}
+
+static int next_enabled(int from) {
+	for (int i = 1; i < num_panels; i++) {
+		int panel = (from + i) % num_panels;
+		if (enabled[panel])
+			return panel;
+	}
+	return from;
+}
+
+static void slide_to(int panel) {
+	if (panel == active)
+		return;
+
+	outgoing = active;
+	active = panel;
+	stats.slides++;
+	if (shown_handler != NULL)
+		shown_handler(active);
+
+	if (!animated) {
+		layer_set_hidden(panels[outgoing], true);
+		layer_set_frame(panels[active], slot);
+		layer_set_hidden(panels[active], false);
+		outgoing = -1;
+		return;
+	}
+
+	ani_out->subject = panels[outgoing];
+	ani_out->values.from.grect = slot;
+	ani_out->values.to.grect = slot_offset(-slot.size.w);
+
+	ani_in->subject = panels[active];
+	ani_in->values.from.grect = slot_offset(slot.size.w);
+	ani_in->values.to.grect = slot;
+
+	layer_set_frame(panels[active], ani_in->values.from.grect);
+	layer_set_hidden(panels[active], false);
+
+	animation_schedule(&ani_out->animation);
+	animation_schedule(&ani_in->animation);
+}
+
+//both animations run the same time, so the incoming one finishing ends the slide
+static void slide_stopped(Animation *animation, bool finished, void *context) {
+	if (!finished)
+		return;
+
+	if (outgoing >= 0 && outgoing != active)
+		layer_set_hidden(panels[outgoing], true);
+	outgoing = -1;
+
+	if (target != active)
+		slide_to(target);
+}
+
+
+Layer *carousel_add_panel(bool is_enabled) {
+	if (num_panels == CAROUSEL_MAX_PANELS)
+		return NULL;
+
+	int panel = num_panels++;
+	bool shown = (panel == active);
+
+	panels[panel] = layer_create(shown ? slot : slot_offset(slot.size.w));
+	enabled[panel] = is_enabled;
+	layer_set_hidden(panels[panel], !shown);
+	layer_add_child(parent_layer, panels[panel]);
+	return panels[panel];
+}
+
+void carousel_set_enabled(int panel, bool is_enabled) {
+	if (panel >= 0 && panel < num_panels)
+		enabled[panel] = is_enabled;
+}
+
+void carousel_set_shown_handler(CarouselShownHandler handler) {
+	shown_handler = handler;
+}
+
+void carousel_set_animated(bool is_animated) {
+	animated = is_animated;
+}
+
+void carousel_next(void) {
+	if (num_panels == 0)
+		return;
+
+	stats.presses++;
+	target = next_enabled(target);
+
+	if (animation_is_scheduled(&ani_in->animation)) {
+		stats.coalesced++;
+		return;
+	}
+	slide_to(target);
+}
+
+int carousel_active(void) {
+	return active;
+}
+
+const CarouselStats *carousel_get_stats(void) {
+	return &stats;
+}
+
+void carousel_init(Layer *parent, GRect frame) {
+	parent_layer = parent;
+	slot = frame;
+	num_panels = 0;
+	active = target = 0;
+	outgoing = -1;
+	animated = true;
+
+	ani_out = property_animation_create_layer_frame(parent, &slot, &slot);
+	ani_in = property_animation_create_layer_frame(parent, &slot, &slot);
+	animation_set_handlers(&ani_in->animation, (AnimationHandlers) {
+		.stopped = slide_stopped
+	}, NULL);
+}
+
+void carousel_deinit(void) {
+	property_animation_destroy(ani_in);
+	property_animation_destroy(ani_out);
+	ani_in = ani_out = NULL;
+
+	for (int i = 0; i < num_panels; i++) {
+		layer_destroy(panels[i]);
+		panels[i] = NULL;
+	}
+	num_panels = 0;
+	shown_handler = NULL;
+}
@@ -0,0 +1,37 @@
+#ifndef _carousel_h
+#define _carousel_h
+
+#include <pebble.h>
+
+//row of panels sharing one screen slot, stepped with a slide. the two slide
+//animations are created once and reused. panels off screen are hidden so
+//they cost nothing to draw, and presses during a slide just move the target.
+
+#define CAROUSEL_MAX_PANELS		10
+
+typedef struct {
+	uint32_t presses;
+	uint32_t slides;
+	uint32_t coalesced;		//presses folded into a slide already under way
+} CarouselStats;
+
+void carousel_init(Layer *parent, GRect slot);
+void carousel_deinit(void);
+
+//creates the panel's layer; disabled panels are skipped when stepping
+Layer *carousel_add_panel(bool enabled);
+
+//told about each panel as it starts to slide in
+typedef void (*CarouselShownHandler)(int panel);
+void carousel_set_shown_handler(CarouselShownHandler handler);
+void carousel_set_enabled(int panel, bool enabled);
+
+//without animation a step swaps the panels at once
+void carousel_set_animated(bool animated);
+
+void carousel_next(void);
+int carousel_active(void);
+
+const CarouselStats *carousel_get_stats(void);
+
+#endif
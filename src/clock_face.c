@@ -0,0 +1,38 @@
+#include <pebble.h>
+#include "clock_face.h"
+#include "render.h"
+
+static TextLayer *time_layer;
+static const char *time_format;
+static bool is_24h;
+
+
+void clock_face_init(Layer *parent, GRect frame, GFont font) {
+	time_layer = text_layer_create(frame);
+	text_layer_set_text_alignment(time_layer, GTextAlignmentCenter);
+	text_layer_set_text_color(time_layer, GColorWhite);
+	text_layer_set_background_color(time_layer, GColorClear);
+	text_layer_set_font(time_layer, font);
+	layer_add_child(parent, text_layer_get_layer(time_layer));
+
+	is_24h = clock_is_24h_style();
+	time_format = is_24h ? "%R" : "%I:%M";
+}
+
+void clock_face_deinit(void) {
+	text_layer_destroy(time_layer);
+	time_layer = NULL;
+}
+
+void clock_face_update(struct tm *tick_time) {
+	//static because the layer keeps pointing at it
+	static char time_text[] = "00:00";
+
+	strftime(time_text, sizeof(time_text), time_format, tick_time);
+
+	//12h clock drops the leading zero, there is no unpadded hour format
+	if (!is_24h && time_text[0] == '0')
+		memmove(time_text, &time_text[1], sizeof(time_text) - 1);
+
+	render_set_text(time_layer, time_text);
+}
@@ -0,0 +1,14 @@
+#ifndef _clock_face_h
+#define _clock_face_h
+
+#include <pebble.h>
+
+//large HH:MM clock in one text layer, set as a whole once a minute
+
+//the 12/24h setting is read here only; changing it means leaving the app
+void clock_face_init(Layer *parent, GRect frame, GFont font);
+void clock_face_deinit(void);
+
+void clock_face_update(struct tm *tick_time);
+
+#endif
@@ -0,0 +1,96 @@
+#include <pebble.h>
+#include "debug_stats.h"
+
+#ifdef SM_DEBUG
+
+DebugStats debug_stats;
+
+static Window *overlay_window;
+static TextLayer *overlay;
+static char overlay_text[320];
+
+
+static void overlay_update(void) {
+	uint16_t draw_max = 0;
+
+	for (int i = DEBUG_DRAW_GAUGE; i < DEBUG_NUM_PATHS; i++)
+		if (debug_stats.max_ms[i] > draw_max)
+			draw_max = debug_stats.max_ms[i];
+
+	snprintf(overlay_text, sizeof(overlay_text),
+		"in %lu msgs, %lu B\n"
+		"out %lu msgs, %lu failed\n"
+		"rcv %lu, max %u ms\n"
+		"tick %lu, max %u ms\n"
+		"send %lu, max %u ms\n"
+		"draws g%lu c%lu s%lu, max %u ms\n"
+		"heap low %lu B",
+		(unsigned long)debug_stats.messages_in, (unsigned long)debug_stats.bytes_in,
+		(unsigned long)debug_stats.messages_out, (unsigned long)debug_stats.outbox_failures,
+		(unsigned long)debug_stats.calls[DEBUG_RCV], debug_stats.max_ms[DEBUG_RCV],
+		(unsigned long)debug_stats.calls[DEBUG_TICK], debug_stats.max_ms[DEBUG_TICK],
+		(unsigned long)debug_stats.calls[DEBUG_SEND], debug_stats.max_ms[DEBUG_SEND],
+		(unsigned long)debug_stats.calls[DEBUG_DRAW_GAUGE], (unsigned long)debug_stats.calls[DEBUG_DRAW_CANVAS],
+		(unsigned long)debug_stats.calls[DEBUG_DRAW_GRAPH], draw_max,
+		(unsigned long)debug_stats.heap_low);
+	text_layer_set_text(overlay, overlay_text);
+}
+
+uint32_t debug_stats_now(void) {
+	time_t seconds;
+	uint16_t ms;
+
+	time_ms(&seconds, &ms);
+	return (uint32_t)seconds * 1000 + ms;
+}
+
+void debug_stats_done(DebugPath path, uint32_t start) {
+	uint32_t elapsed = debug_stats_now() - start;
+	size_t heap = heap_bytes_free();
+
+	debug_stats.calls[path]++;
+	if (elapsed > debug_stats.max_ms[path])
+		debug_stats.max_ms[path] = elapsed > UINT16_MAX ? UINT16_MAX : elapsed;
+	if (heap < debug_stats.heap_low)
+		debug_stats.heap_low = heap;
+
+	//an open overlay follows messages and the clock, not its own redraws
+	if (overlay != NULL && (path == DEBUG_RCV || path == DEBUG_TICK)
+			&& !layer_get_hidden(text_layer_get_layer(overlay)))
+		overlay_update();
+}
+
+//built on the first long press, it costs nothing until someone looks
+void debug_stats_toggle(ClickRecognizerRef recognizer, void *context) {
+	if (overlay == NULL) {
+		Layer *root = window_get_root_layer(overlay_window);
+
+		overlay = text_layer_create(layer_get_bounds(root));
+		text_layer_set_text_color(overlay, GColorWhite);
+		text_layer_set_background_color(overlay, GColorBlack);
+		text_layer_set_font(overlay, fonts_get_system_font(FONT_KEY_GOTHIC_14));
+		layer_add_child(root, text_layer_get_layer(overlay));
+		overlay_update();
+		return;
+	}
+
+	Layer *layer = text_layer_get_layer(overlay);
+	bool show = layer_get_hidden(layer);
+
+	if (show)
+		overlay_update();
+	layer_set_hidden(layer, !show);
+}
+
+void debug_stats_init(Window *window) {
+	overlay_window = window;
+	debug_stats.heap_low = heap_bytes_free();
+}
+
+void debug_stats_deinit(void) {
+	if (overlay != NULL)
+		text_layer_destroy(overlay);
+	overlay = NULL;
+}
+
+#endif
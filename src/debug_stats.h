@@ -0,0 +1,60 @@
+#ifndef _debug_stats_h
+#define _debug_stats_h
+
+#include <pebble.h>
+
+//counters and timers on the hot paths, shown in an overlay that a long DOWN
+//press opens and closes. only built when SM_DEBUG is defined (SM_DEBUG=1
+//pebble build); otherwise every macro below is empty and none of this is
+//compiled in.
+
+#ifdef SM_DEBUG
+
+//timed paths. latency comes from time_ms, so anything under a millisecond reads 0
+typedef enum {
+	DEBUG_RCV,
+	DEBUG_TICK,
+	DEBUG_SEND,
+	DEBUG_DRAW_GAUGE,
+	DEBUG_DRAW_CANVAS,
+	DEBUG_DRAW_GRAPH,
+	DEBUG_NUM_PATHS
+} DebugPath;
+
+typedef struct {
+	uint32_t messages_in;
+	uint32_t bytes_in;
+	uint32_t messages_out;
+	uint32_t outbox_failures;
+	uint32_t calls[DEBUG_NUM_PATHS];		//for the draw paths, redraws of that layer
+	uint16_t max_ms[DEBUG_NUM_PATHS];
+	uint32_t heap_low;						//lowest heap_bytes_free() seen
+} DebugStats;
+
+extern DebugStats debug_stats;
+
+void debug_stats_init(Window *window);
+void debug_stats_deinit(void);
+uint32_t debug_stats_now(void);
+void debug_stats_done(DebugPath path, uint32_t start);
+void debug_stats_toggle(ClickRecognizerRef recognizer, void *context);
+
+#define DEBUG_BEGIN(start)				uint32_t start = debug_stats_now()
+#define DEBUG_END(path, start)			debug_stats_done(path, start)
+#define DEBUG_COUNT(field, n)			(debug_stats.field += (n))
+#define DEBUG_INIT(window)				debug_stats_init(window)
+#define DEBUG_DEINIT()					debug_stats_deinit()
+#define DEBUG_CLICK_SUBSCRIBE(button)	window_long_click_subscribe(button, 700, debug_stats_toggle, NULL)
+
+#else
+
+#define DEBUG_BEGIN(start)
+#define DEBUG_END(path, start)			((void)0)
+#define DEBUG_COUNT(field, n)			((void)0)
+#define DEBUG_INIT(window)				((void)0)
+#define DEBUG_DEINIT()					((void)0)
+#define DEBUG_CLICK_SUBSCRIBE(button)	((void)0)
+
+#endif
+
+#endif
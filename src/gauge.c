@@ -0,0 +1,111 @@
+#include <pebble.h>
+#include "gauge.h"
+#include "debug_stats.h"
+#include "render.h"
+
+#define GAUGE_INSET			2
+#define GAUGE_HEIGHT		8
+
+#define GAUGE_CHARGING		0x1
+#define GAUGE_PLUGGED		0x2
+
+typedef struct {
+	int8_t percent;			//last level set, -1 before the first one
+	int8_t width;			//filled pixels, 0..GAUGE_WIDTH
+	uint8_t state;
+	TextLayer *label;
+	char label_text[4];
+} Gauge;
+
+//percent * 16 / 100 without a division: 41/256 = 0.16015625 floors to the
+//same width for every percent in 0..100
+#define GAUGE_QUANTIZE(percent)		(((percent) * 41) >> 8)
+
+
+static void gauge_draw(Layer *me, GContext *ctx) {
+	Gauge *g = layer_get_data(me);
+	int16_t right = GAUGE_INSET + GAUGE_WIDTH;
+
+	graphics_context_set_stroke_color(ctx, GColorWhite);
+	graphics_context_set_fill_color(ctx, GColorWhite);
+
+	//plugged in but not charging means full
+	if ((g->state & GAUGE_PLUGGED) && !(g->state & GAUGE_CHARGING)) {
+		graphics_fill_rect(ctx, GRect(GAUGE_INSET, GAUGE_INSET, GAUGE_WIDTH, GAUGE_HEIGHT), 0, GCornerNone);
+		return;
+	}
+
+	if (g->width > 0)
+		graphics_fill_rect(ctx, GRect(right - g->width, GAUGE_INSET, g->width, GAUGE_HEIGHT), 0, GCornerNone);
+
+	//charging outlines the part that is still empty
+	if ((g->state & GAUGE_CHARGING) && g->width < GAUGE_WIDTH)
+		graphics_draw_rect(ctx, GRect(GAUGE_INSET, GAUGE_INSET, GAUGE_WIDTH - g->width, GAUGE_HEIGHT));
+}
+
+
+static void gauge_update_proc(Layer *me, GContext *ctx) {
+	DEBUG_BEGIN(start);
+	gauge_draw(me, ctx);
+	DEBUG_END(DEBUG_DRAW_GAUGE, start);
+}
+
+
+Layer *gauge_create(GRect frame) {
+	Layer *layer = layer_create_with_data(frame, sizeof(Gauge));
+	Gauge *g = layer_get_data(layer);
+
+	g->percent = -1;
+	g->width = 0;
+	g->state = 0;
+	g->label = NULL;
+	g->label_text[0] = '\0';
+	layer_set_update_proc(layer, gauge_update_proc);
+	return layer;
+}
+
+void gauge_destroy(Layer *gauge) {
+	layer_destroy(gauge);
+}
+
+void gauge_set_label(Layer *gauge, TextLayer *label) {
+	Gauge *g = layer_get_data(gauge);
+	g->label = label;
+	g->percent = -1;		//written on the next level, whatever it is
+}
+
+bool gauge_set_level(Layer *gauge, int percent, bool charging, bool plugged) {
+	Gauge *g = layer_get_data(gauge);
+	uint8_t state = (charging ? GAUGE_CHARGING : 0) | (plugged ? GAUGE_PLUGGED : 0);
+	int8_t width;
+	bool changed = false;
+
+	if (percent < 0)
+		percent = 0;
+	else if (percent > 100)
+		percent = 100;
+	width = GAUGE_QUANTIZE(percent);
+
+	if (width != g->width || state != g->state) {
+		g->width = width;
+		g->state = state;
+		render_mark_dirty(gauge);
+		changed = true;
+	}
+
+	if (percent != g->percent) {
+		g->percent = percent;
+		if (g->label != NULL) {
+			snprintf(g->label_text, sizeof(g->label_text), "%d", percent);
+			render_set_text(g->label, g->label_text);
+		}
+		changed = true;
+	}
+
+	return changed;
+}
+
+int gauge_get_level(Layer *gauge) {
+	Gauge *g = layer_get_data(gauge);
+	return g->percent;
+}
@@ -0,0 +1,23 @@
+#ifndef _gauge_h
+#define _gauge_h
+
+#include <pebble.h>
+
+//horizontal level bar (battery style) filled from the right. the level is
+//quantized to the bar's pixel width, so only visible changes redraw it.
+
+#define GAUGE_WIDTH		16		//bar width in pixels, giving 17 distinct levels
+
+Layer *gauge_create(GRect frame);
+void gauge_destroy(Layer *gauge);
+
+//optional text layer that shows the percentage; only rewritten when the number changes
+void gauge_set_label(Layer *gauge, TextLayer *label);
+
+//returns false when neither the bar nor the label had to change
+bool gauge_set_level(Layer *gauge, int percent, bool charging, bool plugged);
+
+//last percentage set, -1 if the label was attached after it
+int gauge_get_level(Layer *gauge);
+
+#endif
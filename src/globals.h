@@ -1,85 +1,136 @@
 #ifndef _globals_h
 #define _globals_h
 
-#define SM_RECONNECT_KEY 			0xFC01
-#define SM_SEQUENCE_NUMBER_KEY 		0xFC02
-#define SM_OPEN_SIRI_KEY	 		0xFC03
-#define SM_STATUS_SCREEN_REQ_KEY	0xFC04
-#define SM_PLAYPAUSE_KEY			0xFC05
-#define SM_NEXT_TRACK_KEY			0xFC06
-#define SM_PREVIOUS_TRACK_KEY		0xFC07
-#define SM_VOLUME_UP_KEY			0xFC08
-#define SM_VOLUME_DOWN_KEY			0xFC09
-#define SM_COUNT_MAIL_KEY			0xFC0A
-#define SM_COUNT_SMS_KEY			0xFC0B
-#define SM_COUNT_PHONE_KEY			0xFC0C
-#define SM_COUNT_BATTERY_KEY		0xFC0D
-#define SM_SCREEN_ENTER_KEY			0xFC0E
-#define SM_SCREEN_EXIT_KEY			0xFC0F
-#define SM_WEATHER_COND_KEY			0xFC10
-#define SM_WEATHER_TEMP_KEY			0xFC11
-#define SM_WEATHER_ICON_KEY			0xFC12
-#define SM_STATUS_SCREEN_UPDATE_KEY	0xFC13
-#define SM_VOLUME_VALUE_KEY			0xFC14
-#define SM_PLAY_STATUS_KEY			0xFC15
-#define SM_ARTIST_KEY               0xFC16
-#define SM_ALBUM_KEY                0xFC17
-#define SM_TITLE_KEY                0xFC18
-#define SM_WEATHER_HUMID_KEY		0xFC19
-#define SM_WEATHER_WIND_KEY			0xFC1A
-#define SM_WEATHER_DAY1_KEY			0xFC1B
-#define SM_WEATHER_DAY2_KEY			0xFC1C
-#define SM_WEATHER_DAY3_KEY			0xFC1D
-#define SM_WEATHER_ICON1_KEY		0xFC1E
-#define SM_WEATHER_ICON2_KEY		0xFC1F
-#define SM_WEATHER_ICON3_KEY		0xFC20
-#define SM_CALENDAR_UPDATE_KEY		0xFC21
-#define SM_MENU_UPDATE_KEY			0xFC22
-#define SM_STOCKS_GRAPH_KEY			0xFC23
-#define SM_BITCOIN_GRAPH_KEY		0xFC24
-#define SM_BITCOIN_LOW_KEY			0xFC25
-#define SM_BITCOIN_HIGH_KEY			0xFC26
-#define SM_BITCOIN_CURR_KEY			0xFC27
-#define SM_BITCOIN_TITLE_KEY		0xFC28
-#define SM_STOCKS_LOW_KEY			0xFC29
-#define SM_STOCKS_HIGH_KEY			0xFC2A
-#define SM_STOCKS_CURR_KEY			0xFC2B
-#define SM_STOCKS_TITLE_KEY			0xFC2C
-#define SM_LAUNCH_CAMERA_KEY		0xFC2D
-#define SM_TAKE_PICTURE_KEY			0xFC2E
-#define SM_URL1_KEY					0xFC2F
-#define SM_URL2_KEY					0xFC30
-#define SM_URL1_TEXT_KEY			0xFC31
-#define SM_URL2_TEXT_KEY			0xFC32
-#define SM_GPS_1_KEY				0xFC33
-#define SM_GPS_2_KEY				0xFC34
-#define SM_GPS_3_KEY				0xFC35
-#define SM_GPS_4_KEY				0xFC36
-#define SM_RESET_DST_KEY			0xFC37
-#define SM_MESSAGES_UPDATE_KEY		0xFC38
-#define SM_CALLS_UPDATE_KEY			0xFC38
-#define SM_CAL_DETAILS_KEY			0xFC39
-#define SM_DETAILS1_KEY				0xFC3A
-#define SM_DETAILS2_KEY				0xFC3B
-#define SM_CALL_SMS_KEY				0xFC3C
-#define SM_CALL_SMS_UPDATE_KEY		0xFC3D
-#define SM_CALL_SMS_CMD_KEY			0xFC3E
-#define SM_SMS_SENT_KEY             0xFC3F
-#define SM_FIND_MY_PHONE_KEY        0xFC40
-#define SM_REMINDERS_KEY 	       	0xFC41
-#define SM_REMINDERS_DETAILS_KEY    0xFC42
-#define SM_STATUS_CAL_TIME_KEY   	0xFC43
-#define SM_STATUS_CAL_TEXT_KEY   	0xFC44
-#define SM_STATUS_MUS_ARTIST_KEY	0xFC45
-#define SM_STATUS_MUS_TITLE_KEY		0xFC46
-#define SM_UPDATE_INTERVAL_KEY		0xFC47
-#define SM_SONG_LENGTH_KEY          0xFC48
-#define SM_STATUS_UPD_WEATHER_KEY   0xFC49
-#define SM_STATUS_UPD_CAL_KEY       0xFC4A
-#define SM_NAV_ICON_KEY             0xFC4B
-#define SM_NAV_INSTRUCTIONS_KEY     0xFC4C
-#define SM_STREAMING_BMP_KEY    	0xFC4D
-#define SM_CANVAS_DICT_KEY          0xFC4E
+//message schema for the phone protocol.
+//X(key, value, tuple type, max inbound length, max outbound length)
+//lengths are value bytes as the status screen sends or accepts them, 0 means
+//the status screen never sees the key in that direction. inbox and outbox are
+//sized for every key at its maximum at once, so the sizes are an upper bound
+//for a whole message, not a limit per string: a string over its own maximum
+//still fits when other keys are absent. only a message over the total is
+//dropped by the firmware.
+enum {SM_NONE, SM_INT, SM_CSTRING, SM_BYTES};
+
+//SM_STATUS_GEN_KEY carries the phone's session byte, then one generation byte per
+//status section, in this order. the phone sends its current generations, the watch
+//echoes the ones it has so the phone only resends sections that changed. 0 means
+//the section is unknown. the phone picks a new session each time it starts and
+//numbers its sections from 1 again; generations only compare within a session.
+enum {SM_SECTION_WEATHER, SM_SECTION_CALENDAR, SM_SECTION_MUSIC, SM_SECTION_BATTERY, SM_NUM_SECTIONS};
+#define SM_STATUS_GEN_SIZE			(1 + SM_NUM_SECTIONS)
+
+#define SM_MESSAGE_SCHEMA(X) \
+	X(SM_RECONNECT_KEY,            0xFC01, SM_NONE,    0,               0) \
+	X(SM_SEQUENCE_NUMBER_KEY,      0xFC02, SM_INT,     4,               4) \
+	X(SM_OPEN_SIRI_KEY,            0xFC03, SM_NONE,    0,               0) \
+	X(SM_STATUS_SCREEN_REQ_KEY,    0xFC04, SM_NONE,    0,               0) \
+	X(SM_PLAYPAUSE_KEY,            0xFC05, SM_NONE,    0,               0) \
+	X(SM_NEXT_TRACK_KEY,           0xFC06, SM_NONE,    0,               0) \
+	X(SM_PREVIOUS_TRACK_KEY,       0xFC07, SM_NONE,    0,               0) \
+	X(SM_VOLUME_UP_KEY,            0xFC08, SM_NONE,    0,               0) \
+	X(SM_VOLUME_DOWN_KEY,          0xFC09, SM_NONE,    0,               0) \
+	X(SM_COUNT_MAIL_KEY,           0xFC0A, SM_NONE,    0,               0) \
+	X(SM_COUNT_SMS_KEY,            0xFC0B, SM_NONE,    0,               0) \
+	X(SM_COUNT_PHONE_KEY,          0xFC0C, SM_NONE,    0,               0) \
+	X(SM_COUNT_BATTERY_KEY,        0xFC0D, SM_INT,     4,               0) \
+	X(SM_SCREEN_ENTER_KEY,         0xFC0E, SM_INT,     0,               1) \
+	X(SM_SCREEN_EXIT_KEY,          0xFC0F, SM_INT,     0,               1) \
+	X(SM_WEATHER_COND_KEY,         0xFC10, SM_CSTRING, 64,              0) \
+	X(SM_WEATHER_TEMP_KEY,         0xFC11, SM_CSTRING, 16,              0) \
+	X(SM_WEATHER_ICON_KEY,         0xFC12, SM_INT,     4,               0) \
+	X(SM_STATUS_SCREEN_UPDATE_KEY, 0xFC13, SM_NONE,    0,               0) \
+	X(SM_VOLUME_VALUE_KEY,         0xFC14, SM_NONE,    0,               0) \
+	X(SM_PLAY_STATUS_KEY,          0xFC15, SM_NONE,    0,               0) \
+	X(SM_ARTIST_KEY,               0xFC16, SM_NONE,    0,               0) \
+	X(SM_ALBUM_KEY,                0xFC17, SM_NONE,    0,               0) \
+	X(SM_TITLE_KEY,                0xFC18, SM_NONE,    0,               0) \
+	X(SM_WEATHER_HUMID_KEY,        0xFC19, SM_NONE,    0,               0) \
+	X(SM_WEATHER_WIND_KEY,         0xFC1A, SM_NONE,    0,               0) \
+	X(SM_WEATHER_DAY1_KEY,         0xFC1B, SM_CSTRING, 16,              0) \
+	X(SM_WEATHER_DAY2_KEY,         0xFC1C, SM_CSTRING, 16,              0) \
+	X(SM_WEATHER_DAY3_KEY,         0xFC1D, SM_CSTRING, 16,              0) \
+	X(SM_WEATHER_ICON1_KEY,        0xFC1E, SM_INT,     4,               0) \
+	X(SM_WEATHER_ICON2_KEY,        0xFC1F, SM_INT,     4,               0) \
+	X(SM_WEATHER_ICON3_KEY,        0xFC20, SM_INT,     4,               0) \
+	X(SM_CALENDAR_UPDATE_KEY,      0xFC21, SM_NONE,    0,               0) \
+	X(SM_MENU_UPDATE_KEY,          0xFC22, SM_NONE,    0,               0) \
+	X(SM_STOCKS_GRAPH_KEY,         0xFC23, SM_BYTES,   64,              0) \
+	X(SM_BITCOIN_GRAPH_KEY,        0xFC24, SM_BYTES,   64,              0) \
+	X(SM_BITCOIN_LOW_KEY,          0xFC25, SM_CSTRING, 16,              0) \
+	X(SM_BITCOIN_HIGH_KEY,         0xFC26, SM_CSTRING, 16,              0) \
+	X(SM_BITCOIN_CURR_KEY,         0xFC27, SM_CSTRING, 16,              0) \
+	X(SM_BITCOIN_TITLE_KEY,        0xFC28, SM_CSTRING, 32,              0) \
+	X(SM_STOCKS_LOW_KEY,           0xFC29, SM_CSTRING, 16,              0) \
+	X(SM_STOCKS_HIGH_KEY,          0xFC2A, SM_CSTRING, 16,              0) \
+	X(SM_STOCKS_CURR_KEY,          0xFC2B, SM_CSTRING, 16,              0) \
+	X(SM_STOCKS_TITLE_KEY,         0xFC2C, SM_CSTRING, 32,              0) \
+	X(SM_LAUNCH_CAMERA_KEY,        0xFC2D, SM_NONE,    0,               0) \
+	X(SM_TAKE_PICTURE_KEY,         0xFC2E, SM_NONE,    0,               0) \
+	X(SM_URL1_KEY,                 0xFC2F, SM_NONE,    0,               0) \
+	X(SM_URL2_KEY,                 0xFC30, SM_NONE,    0,               0) \
+	X(SM_URL1_TEXT_KEY,            0xFC31, SM_NONE,    0,               0) \
+	X(SM_URL2_TEXT_KEY,            0xFC32, SM_NONE,    0,               0) \
+	X(SM_GPS_1_KEY,                0xFC33, SM_NONE,    0,               0) \
+	X(SM_GPS_2_KEY,                0xFC34, SM_NONE,    0,               0) \
+	X(SM_GPS_3_KEY,                0xFC35, SM_NONE,    0,               0) \
+	X(SM_GPS_4_KEY,                0xFC36, SM_NONE,    0,               0) \
+	X(SM_RESET_DST_KEY,            0xFC37, SM_NONE,    0,               0) \
+	X(SM_MESSAGES_UPDATE_KEY,      0xFC38, SM_NONE,    0,               0) \
+	X(SM_CAL_DETAILS_KEY,          0xFC39, SM_NONE,    0,               0) \
+	X(SM_DETAILS1_KEY,             0xFC3A, SM_NONE,    0,               0) \
+	X(SM_DETAILS2_KEY,             0xFC3B, SM_NONE,    0,               0) \
+	X(SM_CALL_SMS_KEY,             0xFC3C, SM_NONE,    0,               0) \
+	X(SM_CALL_SMS_UPDATE_KEY,      0xFC3D, SM_NONE,    0,               0) \
+	X(SM_CALL_SMS_CMD_KEY,         0xFC3E, SM_NONE,    0,               0) \
+	X(SM_SMS_SENT_KEY,             0xFC3F, SM_NONE,    0,               0) \
+	X(SM_FIND_MY_PHONE_KEY,        0xFC40, SM_NONE,    0,               0) \
+	X(SM_REMINDERS_KEY,            0xFC41, SM_CSTRING, 64,              0) \
+	X(SM_REMINDERS_DETAILS_KEY,    0xFC42, SM_NONE,    0,               0) \
+	X(SM_STATUS_CAL_TIME_KEY,      0xFC43, SM_CSTRING, 64,              0) \
+	X(SM_STATUS_CAL_TEXT_KEY,      0xFC44, SM_CSTRING, 128,             0) \
+	X(SM_STATUS_MUS_ARTIST_KEY,    0xFC45, SM_CSTRING, 64,              0) \
+	X(SM_STATUS_MUS_TITLE_KEY,     0xFC46, SM_CSTRING, 128,             0) \
+	X(SM_UPDATE_INTERVAL_KEY,      0xFC47, SM_NONE,    0,               0) \
+	X(SM_SONG_LENGTH_KEY,          0xFC48, SM_INT,     4,               1) \
+	X(SM_STATUS_UPD_WEATHER_KEY,   0xFC49, SM_INT,     4,               1) \
+	X(SM_STATUS_UPD_CAL_KEY,       0xFC4A, SM_INT,     4,               1) \
+	X(SM_NAV_ICON_KEY,             0xFC4B, SM_NONE,    0,               0) \
+	X(SM_NAV_INSTRUCTIONS_KEY,     0xFC4C, SM_CSTRING, 64,              0) \
+	X(SM_STREAMING_BMP_KEY,        0xFC4D, SM_BYTES,   128,             0) \
+	X(SM_CANVAS_DICT_KEY,          0xFC4E, SM_BYTES,   128,             0) \
+	X(SM_STATUS_GEN_KEY,           0xFC4F, SM_BYTES,   SM_STATUS_GEN_SIZE, SM_STATUS_GEN_SIZE)
+
+#define SM_KEY_ENUM(key, value, type, in_max, out_max)	key = value,
+enum {SM_MESSAGE_SCHEMA(SM_KEY_ENUM)};
+
+//the phone uses the same key for both updates
+#define SM_CALLS_UPDATE_KEY			SM_MESSAGES_UPDATE_KEY
+
+#define SM_FIRST_KEY				SM_RECONNECT_KEY
+#define SM_LAST_KEY					SM_STATUS_GEN_KEY
+#define SM_NUM_KEYS					(SM_LAST_KEY - SM_FIRST_KEY + 1)
+
+//exact buffer sizes, same layout dict_calc_buffer_size() uses: a count byte plus
+//key, type and length in front of every value
+#define SM_DICT_HEADER_SIZE			1
+#define SM_TUPLE_HEADER_SIZE		7
+#define SM_INBOX_TUPLE(key, value, type, in_max, out_max)	+ ((in_max) ? SM_TUPLE_HEADER_SIZE + (in_max) : 0)
+#define SM_OUTBOX_TUPLE(key, value, type, in_max, out_max)	+ ((out_max) ? SM_TUPLE_HEADER_SIZE + (out_max) : 0)
+#define SM_INBOX_SIZE				(SM_DICT_HEADER_SIZE SM_MESSAGE_SCHEMA(SM_INBOX_TUPLE))
+#define SM_OUTBOX_SIZE				(SM_DICT_HEADER_SIZE SM_MESSAGE_SCHEMA(SM_OUTBOX_TUPLE))
+
+#define SM_KEY_RANGE_CHECK(key, value, type, in_max, out_max) \
+	_Static_assert((value) >= SM_FIRST_KEY && (value) <= SM_LAST_KEY, #key " is outside SM_FIRST_KEY..SM_LAST_KEY");
+SM_MESSAGE_SCHEMA(SM_KEY_RANGE_CHECK)
+
+//does not compile (duplicate case value) if two keys share a number
+#define SM_KEY_CASE(key, value, type, in_max, out_max)	case value:
+static inline void sm_check_unique_keys(uint32_t key) {
+	switch (key) {
+		SM_MESSAGE_SCHEMA(SM_KEY_CASE)
+			break;
+	}
+}
 
 
 
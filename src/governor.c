@@ -0,0 +1,58 @@
+#include <pebble.h>
+#include "governor.h"
+
+static BatteryChargeState battery_now;
+static LinkState link_now;
+static GovernorHandler handler;
+
+static GovernorPolicy policy = {GOVERNOR_FULL, 1, true};
+
+
+static void update(void) {
+	bool low = battery_now.charge_percent < GOVERNOR_LOW_BATTERY && !battery_now.is_charging && !battery_now.is_plugged;
+	GovernorPolicy next = {GOVERNOR_FULL, 1, !low};
+
+	if (link_now != LINK_LIVE) {
+		next.mode = GOVERNOR_PAUSED;
+		next.poll_scale = 0;
+	} else if (low) {
+		next.mode = GOVERNOR_SAVING;
+		next.poll_scale = GOVERNOR_LOW_SCALE;
+	}
+
+	if (next.mode == policy.mode && next.poll_scale == policy.poll_scale && next.animate == policy.animate)
+		return;
+	policy = next;
+	if (handler != NULL)
+		handler(&policy);
+}
+
+
+void governor_battery_changed(BatteryChargeState state) {
+	battery_now = state;
+	update();
+}
+
+void governor_link_changed(LinkState state) {
+	link_now = state;
+	update();
+}
+
+const GovernorPolicy *governor_get_policy(void) {
+	return &policy;
+}
+
+void governor_init(BatteryChargeState state, LinkState link_state, GovernorHandler policy_handler) {
+	battery_now = state;
+	link_now = link_state;
+	handler = NULL;
+	update();
+
+	handler = policy_handler;
+	if (handler != NULL)
+		handler(&policy);
+}
+
+void governor_deinit(void) {
+	handler = NULL;
+}
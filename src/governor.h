@@ -0,0 +1,42 @@
+#ifndef _governor_h
+#define _governor_h
+
+#include <pebble.h>
+#include "link.h"
+
+//decides how hard the app works from the watch battery and the link:
+//
+//  link not live               polls paused, the phone could not answer them
+//  charging or plugged in      polls at the phone's rate, animations on
+//  below GOVERNOR_LOW_BATTERY  polls GOVERNOR_LOW_SCALE times apart, no animations
+//  otherwise                   polls at the phone's rate, animations on
+//
+//the handler is called with the new policy whenever it changes, and once
+//from governor_init.
+
+#define GOVERNOR_LOW_BATTERY	20		//percent
+#define GOVERNOR_LOW_SCALE		4
+
+typedef enum {
+	GOVERNOR_FULL,
+	GOVERNOR_SAVING,
+	GOVERNOR_PAUSED
+} GovernorMode;
+
+typedef struct {
+	GovernorMode mode;
+	uint8_t poll_scale;		//phone poll intervals are multiplied by this, 0 while paused
+	bool animate;			//panel slides and scrolling text
+} GovernorPolicy;
+
+typedef void (*GovernorHandler)(const GovernorPolicy *policy);
+
+void governor_init(BatteryChargeState battery, LinkState link, GovernorHandler handler);
+void governor_deinit(void);
+
+void governor_battery_changed(BatteryChargeState battery);
+void governor_link_changed(LinkState link);
+
+const GovernorPolicy *governor_get_policy(void);
+
+#endif
@@ -0,0 +1,155 @@
+#include <pebble.h>
+#include "link.h"
+
+#define SETTLE_BASE_MS		5000
+#define SETTLE_MAX_MS		30000
+#define SYNC_TIMEOUT_MS		15000
+
+static LinkState state = LINK_DISCONNECTED;
+static LinkHandlers handlers;
+static LinkStats stats;
+
+static AppTimer *timerLink = NULL;
+static int backoff;					//doublings of the settle time
+
+static time_t up_seconds;			//when the link last came up
+static uint16_t up_ms;
+
+
+static void link_timeout(void *data);
+
+static void set_state(LinkState next) {
+	if (next == state)
+		return;
+	state = next;
+	if (handlers.changed)
+		handlers.changed(state);
+}
+
+static void set_timer(uint32_t delay) {
+	if (timerLink == NULL || !app_timer_reschedule(timerLink, delay))
+		timerLink = app_timer_register(delay, link_timeout, NULL);
+}
+
+static void cancel_timer(void) {
+	if (timerLink != NULL)
+		app_timer_cancel(timerLink);
+	timerLink = NULL;
+}
+
+static void settle(void) {
+	uint32_t delay = SETTLE_BASE_MS << (backoff < 4 ? backoff : 4);
+	if (delay > SETTLE_MAX_MS)
+		delay = SETTLE_MAX_MS;
+
+	set_timer(delay);
+	set_state(LINK_SETTLING);
+}
+
+static void link_timeout(void *data) {
+	timerLink = NULL;
+
+	switch (state) {
+		case LINK_SETTLING:
+			//stayed up long enough, resync and wait for the phone to answer
+			state = LINK_SYNCING;
+			stats.resyncs++;
+			set_timer(SYNC_TIMEOUT_MS);
+			if (handlers.resync)
+				handlers.resync();
+			if (handlers.changed)
+				handlers.changed(state);
+			break;
+
+		case LINK_SYNCING:
+			//connected but the phone did not answer, try again later
+			backoff++;
+			settle();
+			break;
+
+		default:
+			break;
+	}
+}
+
+static uint32_t ms_since_up(void) {
+	time_t seconds;
+	uint16_t ms;
+
+	time_ms(&seconds, &ms);
+	return (uint32_t)(seconds - up_seconds) * 1000 + ms - up_ms;
+}
+
+
+void link_connection_changed(bool connected) {
+	if (connected) {
+		if (state != LINK_DISCONNECTED)
+			return;
+
+		time_ms(&up_seconds, &up_ms);
+		settle();
+		return;
+	}
+
+	switch (state) {
+		case LINK_DISCONNECTED:
+			return;
+
+		case LINK_SETTLING:
+			stats.flaps++;
+			backoff++;
+			break;
+
+		case LINK_SYNCING:
+		case LINK_LIVE:
+			stats.drops++;
+			if (handlers.lost)
+				handlers.lost();
+			break;
+	}
+
+	cancel_timer();
+	set_state(LINK_DISCONNECTED);
+}
+
+void link_message_received(void) {
+	if (state != LINK_SYNCING)
+		return;
+
+	cancel_timer();
+	backoff = 0;
+	set_state(LINK_LIVE);
+
+	stats.last_latency_ms = ms_since_up();
+	if (stats.last_latency_ms > stats.max_latency_ms)
+		stats.max_latency_ms = stats.last_latency_ms;
+	APP_LOG(APP_LOG_LEVEL_DEBUG, "link live after %lu ms", (unsigned long)stats.last_latency_ms);
+}
+
+LinkState link_get_state(void) {
+	return state;
+}
+
+const LinkStats *link_get_stats(void) {
+	return &stats;
+}
+
+//the app asks for the status itself when its window appears, so a link that
+//is up at start goes straight to syncing
+void link_init(bool connected, LinkHandlers link_handlers) {
+	handlers = link_handlers;
+	backoff = 0;
+
+	if (connected) {
+		time_ms(&up_seconds, &up_ms);
+		state = LINK_SYNCING;
+		set_timer(SYNC_TIMEOUT_MS);
+	} else {
+		state = LINK_DISCONNECTED;
+	}
+}
+
+void link_deinit(void) {
+	cancel_timer();
+	state = LINK_DISCONNECTED;
+}
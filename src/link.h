@@ -0,0 +1,43 @@
+#ifndef _link_h
+#define _link_h
+
+#include <pebble.h>
+
+//bluetooth connection state. a new connection has to stay up for the settle
+//time before the status is requested again; every drop while settling
+//doubles that time, so a flapping link does not cause a resync storm.
+//
+//  disconnected -> settling -> syncing -> live
+//        ^____________|___________|________|   (link lost)
+
+typedef enum {
+	LINK_DISCONNECTED,
+	LINK_SETTLING,
+	LINK_SYNCING,
+	LINK_LIVE
+} LinkState;
+
+typedef struct {
+	uint32_t drops;					//connection lost while live or syncing
+	uint32_t flaps;					//connection lost again while settling
+	uint32_t resyncs;
+	uint32_t last_latency_ms;		//link up to first status message
+	uint32_t max_latency_ms;
+} LinkStats;
+
+typedef struct {
+	void (*lost)(void);				//link went away after being usable
+	void (*resync)(void);			//link is stable, ask the phone for everything
+	void (*changed)(LinkState state);	//any state change, after lost or resync
+} LinkHandlers;
+
+void link_init(bool connected, LinkHandlers handlers);
+void link_deinit(void);
+
+void link_connection_changed(bool connected);
+void link_message_received(void);
+
+LinkState link_get_state(void);
+const LinkStats *link_get_stats(void);
+
+#endif
@@ -0,0 +1,116 @@
+#include <pebble.h>
+#include "marquee.h"
+
+typedef struct {
+	TextLayer *text;
+	GFont font;
+	int16_t w, h;
+	int16_t overflow;			//measured width past the frame, 0 when the text fits
+	int16_t offset;
+	uint8_t passes;
+	bool visible;
+	AppTimer *timer;
+} Marquee;
+
+static MarqueeStats stats;
+
+
+static void move_to(Marquee *m, int16_t offset) {
+	m->offset = offset;
+	layer_set_frame(text_layer_get_layer(m->text), GRect(-offset, 0, MARQUEE_MAX_WIDTH, m->h));
+}
+
+static void stop(Marquee *m) {
+	if (m->timer != NULL)
+		app_timer_cancel(m->timer);
+	m->timer = NULL;
+	if (m->offset != 0)
+		move_to(m, 0);
+}
+
+//scroll to the end, pause, jump back to the start, pause, and again
+static void step(void *data) {
+	Marquee *m = data;
+
+	m->timer = NULL;
+	if (m->offset >= m->overflow) {
+		move_to(m, 0);
+		stats.passes++;
+		if (++m->passes < MARQUEE_PASSES)
+			m->timer = app_timer_register(MARQUEE_PAUSE_MS, step, m);
+		return;
+	}
+
+	move_to(m, m->offset + MARQUEE_STEP_PX < m->overflow ? m->offset + MARQUEE_STEP_PX : m->overflow);
+	stats.steps++;
+	m->timer = app_timer_register(m->offset == m->overflow ? MARQUEE_PAUSE_MS : MARQUEE_STEP_MS, step, m);
+}
+
+static void start(Marquee *m) {
+	stop(m);
+	m->passes = 0;
+	if (m->visible && m->overflow > 0)
+		m->timer = app_timer_register(MARQUEE_PAUSE_MS, step, m);
+}
+
+
+Layer *marquee_create(GRect frame, GFont font) {
+	Layer *layer = layer_create_with_data(frame, sizeof(Marquee));
+	Marquee *m = layer_get_data(layer);
+
+	memset(m, 0, sizeof(*m));
+	m->font = font;
+	m->w = frame.size.w;
+	m->h = frame.size.h;
+	m->visible = true;
+
+	m->text = text_layer_create(GRect(0, 0, MARQUEE_MAX_WIDTH, m->h));
+	text_layer_set_text_alignment(m->text, GTextAlignmentLeft);
+	text_layer_set_overflow_mode(m->text, GTextOverflowModeTrailingEllipsis);
+	text_layer_set_text_color(m->text, GColorWhite);
+	text_layer_set_background_color(m->text, GColorClear);
+	text_layer_set_font(m->text, font);
+	layer_set_clips(layer, true);
+	layer_add_child(layer, text_layer_get_layer(m->text));
+	return layer;
+}
+
+void marquee_destroy(Layer *marquee) {
+	Marquee *m = layer_get_data(marquee);
+
+	if (m->timer != NULL)
+		app_timer_cancel(m->timer);
+	text_layer_destroy(m->text);
+	layer_destroy(marquee);
+}
+
+TextLayer *marquee_get_text_layer(Layer *marquee) {
+	Marquee *m = layer_get_data(marquee);
+	return m->text;
+}
+
+void marquee_text_changed(Layer *marquee, const char *text) {
+	Marquee *m = layer_get_data(marquee);
+	GSize size = graphics_text_layout_get_content_size(text, m->font, GRect(0, 0, MARQUEE_MAX_WIDTH, m->h),
+		GTextOverflowModeTrailingEllipsis, GTextAlignmentLeft);
+
+	stats.measures++;
+	m->overflow = size.w > m->w ? size.w - m->w : 0;
+	start(m);
+}
+
+void marquee_set_visible(Layer *marquee, bool visible) {
+	Marquee *m = layer_get_data(marquee);
+
+	if (visible == m->visible)
+		return;
+	m->visible = visible;
+	if (visible)
+		start(m);
+	else
+		stop(m);
+}
+
+const MarqueeStats *marquee_get_stats(void) {
+	return &stats;
+}
@@ -0,0 +1,38 @@
+#ifndef _marquee_h
+#define _marquee_h
+
+#include <pebble.h>
+
+//one line of text that scrolls sideways when it is wider than its frame. the
+//text is measured once when it changes; scrolling only moves a text layer of
+//fixed size inside a clipping layer, so its layout is reused on every step.
+//it runs while the marquee is visible and stops at the start after
+//MARQUEE_PASSES passes.
+
+#define MARQUEE_MAX_WIDTH	384		//widest line laid out, longer text ends in an ellipsis; also sizes the text fields
+#define MARQUEE_STEP_PX		4
+#define MARQUEE_STEP_MS		100		//10 steps a second, one text draw each
+#define MARQUEE_PAUSE_MS	1500	//at either end of a pass
+#define MARQUEE_PASSES		3
+
+typedef struct {
+	uint32_t measures;		//texts laid out to find their width
+	uint32_t steps;			//scroll steps drawn
+	uint32_t passes;		//passes completed
+} MarqueeStats;
+
+Layer *marquee_create(GRect frame, GFont font);
+void marquee_destroy(Layer *marquee);
+
+//the layer that holds the text, for text_layer_set_text() and render_set_text()
+TextLayer *marquee_get_text_layer(Layer *marquee);
+
+//call with the text the layer is about to show; restarts scrolling if it does not fit
+void marquee_text_changed(Layer *marquee, const char *text);
+
+//hidden marquees rest at the start and use no timer
+void marquee_set_visible(Layer *marquee, bool visible);
+
+const MarqueeStats *marquee_get_stats(void);
+
+#endif
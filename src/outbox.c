@@ -0,0 +1,172 @@
+#include <pebble.h>
+#include "sm_watchapp.h"
+#include "outbox.h"
+#include "debug_stats.h"
+
+#define OUTBOX_CAPACITY		8
+#define RETRY_BASE_MS		250
+#define RETRY_MAX_MS		16000
+
+typedef struct {
+	uint32_t key;
+	int8_t value;
+} Command;
+
+static Command pending[OUTBOX_CAPACITY], in_flight[OUTBOX_CAPACITY];
+static int num_pending, num_in_flight;
+
+static AppTimer *retryTimer = NULL;
+static int retries;
+static int holds;
+static bool isOpen = false;
+static bool connected = true;
+
+static OutboxStats stats;
+
+
+//add a command to the pending list. with replace set a pending command with the
+//same key takes the new value, otherwise the pending (newer) one is kept
+static void pending_add(uint32_t key, int8_t value, bool replace) {
+	for (int i = 0; i < num_pending; i++) {
+		if (pending[i].key == key) {
+			if (replace)
+				pending[i].value = value;
+			stats.merged++;
+			return;
+		}
+	}
+
+	if (num_pending == OUTBOX_CAPACITY) {
+		APP_LOG(APP_LOG_LEVEL_WARNING, "outbox full, dropping 0x%lx", (unsigned long)key);
+		stats.dropped++;
+		return;
+	}
+	pending[num_pending++] = (Command){key, value};
+}
+
+static void flush(void);
+
+static void retry(void *data) {
+	retryTimer = NULL;
+	flush();
+}
+
+//nothing is retried while the phone is away, outbox_connection_changed flushes
+static void schedule_retry(void) {
+	if (retryTimer != NULL || !connected)
+		return;
+
+	uint32_t delay = RETRY_BASE_MS << (retries < 6 ? retries : 6);
+	if (delay > RETRY_MAX_MS)
+		delay = RETRY_MAX_MS;
+
+	retries++;
+	stats.retries++;
+	retryTimer = app_timer_register(delay, retry, NULL);
+}
+
+//pack everything pending into one dictionary. the sequence number is only
+//advanced once app_message_outbox_send() has taken the message
+static void flush(void) {
+	if (num_in_flight > 0 || num_pending == 0 || retryTimer != NULL || holds > 0 || !connected)
+		return;
+
+	DictionaryIterator *iter = NULL;
+	if (sm_message_out_get(&iter) != APP_MSG_OK || iter == NULL) {
+		schedule_retry();
+		return;
+	}
+
+	for (int i = 0; i < num_pending; i++)
+		dict_write_int8(iter, pending[i].key, pending[i].value);
+
+	if (app_message_outbox_send() != APP_MSG_OK) {
+		DEBUG_COUNT(outbox_failures, 1);
+		schedule_retry();
+		return;
+	}
+	sm_message_out_sent();
+
+	memcpy(in_flight, pending, num_pending * sizeof(Command));
+	num_in_flight = num_pending;
+	num_pending = 0;
+	stats.messages++;
+	DEBUG_COUNT(messages_out, 1);
+}
+
+static void outbox_sent(DictionaryIterator *iter, void *context) {
+	num_in_flight = 0;
+	retries = 0;
+	flush();
+}
+
+static void outbox_failed(DictionaryIterator *iter, AppMessageResult reason, void *context) {
+	APP_LOG(APP_LOG_LEVEL_DEBUG, "outbox failed %d, %d commands", reason, num_in_flight);
+	DEBUG_COUNT(outbox_failures, 1);
+
+	//put the lost commands back unless something newer for the same key is queued
+	for (int i = 0; i < num_in_flight; i++)
+		pending_add(in_flight[i].key, in_flight[i].value, false);
+	num_in_flight = 0;
+
+	schedule_retry();
+}
+
+
+void outbox_send_command(uint32_t key, int8_t value) {
+	if (!isOpen)
+		return;
+
+	DEBUG_BEGIN(start);
+	stats.queued++;
+	pending_add(key, value, true);
+	flush();
+	DEBUG_END(DEBUG_SEND, start);
+}
+
+void outbox_hold(void) {
+	holds++;
+}
+
+void outbox_release(void) {
+	if (holds > 0 && --holds == 0)
+		flush();
+}
+
+void outbox_connection_changed(bool is_connected) {
+	connected = is_connected;
+	if (retryTimer != NULL)
+		app_timer_cancel(retryTimer);
+	retryTimer = NULL;
+	retries = 0;
+
+	if (connected)
+		flush();
+}
+
+bool outbox_is_idle(void) {
+	return num_pending == 0 && num_in_flight == 0;
+}
+
+const OutboxStats *outbox_get_stats(void) {
+	return &stats;
+}
+
+void outbox_init(void) {
+	app_message_register_outbox_sent(outbox_sent);
+	app_message_register_outbox_failed(outbox_failed);
+	connected = bluetooth_connection_service_peek();
+	isOpen = true;
+}
+
+void outbox_deinit(void) {
+	isOpen = false;
+
+	if (retryTimer != NULL)
+		app_timer_cancel(retryTimer);
+	retryTimer = NULL;
+
+	num_pending = 0;
+	num_in_flight = 0;
+	holds = 0;
+}
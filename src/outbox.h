@@ -0,0 +1,33 @@
+#ifndef _outbox_h
+#define _outbox_h
+
+#include <pebble.h>
+
+//outbound command queue. commands are merged by key, packed into as few
+//dictionaries as possible and retried with backoff when the phone NACKs.
+//while bluetooth is down commands are only queued, they go out on link up.
+
+typedef struct {
+	uint32_t queued;
+	uint32_t merged;
+	uint32_t messages;
+	uint32_t retries;
+	uint32_t dropped;
+} OutboxStats;
+
+void outbox_init(void);
+void outbox_deinit(void);
+
+//queue key=value for the phone; a pending command with the same key is replaced
+void outbox_send_command(uint32_t key, int8_t value);
+
+//commands queued between hold and release go out together in one dictionary
+void outbox_hold(void);
+void outbox_release(void);
+
+void outbox_connection_changed(bool connected);
+
+bool outbox_is_idle(void);
+const OutboxStats *outbox_get_stats(void);
+
+#endif
@@ -0,0 +1,164 @@
+#include <pebble.h>
+#include "globals.h"
+#include "sm_watchapp.h"
+#include "outbox.h"
+#include "refresh.h"
+
+#define NO_DEADLINE		0
+
+//command that asks the phone for each section; battery comes with the weather
+static const uint32_t POLL_KEYS[SM_NUM_SECTIONS] = {
+	[SM_SECTION_WEATHER]	= SM_STATUS_UPD_WEATHER_KEY,
+	[SM_SECTION_CALENDAR]	= SM_STATUS_UPD_CAL_KEY,
+	[SM_SECTION_MUSIC]		= SM_SONG_LENGTH_KEY,
+	[SM_SECTION_BATTERY]	= 0,
+};
+
+//times are ms since refresh_init, so 32 bits last 49 days. a section is due
+//interval * scale after it was scheduled.
+static uint32_t scheduled[SM_NUM_SECTIONS];
+static uint32_t interval[SM_NUM_SECTIONS];
+static uint8_t scale = 1;
+static bool suspended;
+static uint32_t slack;
+static time_t epoch;
+
+static AppTimer *timerRefresh = NULL;
+static RefreshStats stats;
+
+
+static uint32_t now_ms(void) {
+	time_t seconds;
+	uint16_t ms;
+
+	time_ms(&seconds, &ms);
+	return (uint32_t)(seconds - epoch) * 1000 + ms + 1;		//+1 keeps NO_DEADLINE free
+}
+
+static uint32_t deadline(int section) {
+	if (scheduled[section] == NO_DEADLINE || scale == 0 || suspended)
+		return NO_DEADLINE;
+	return scheduled[section] + interval[section] * scale;
+}
+
+static void fire(void *data);
+
+//point the single timer at the earliest deadline
+static void arm(void) {
+	uint32_t earliest = NO_DEADLINE;
+
+	for (int i = 0; i < SM_NUM_SECTIONS; i++) {
+		uint32_t due = deadline(i);
+		if (due != NO_DEADLINE && (earliest == NO_DEADLINE || due < earliest))
+			earliest = due;
+	}
+
+	if (earliest == NO_DEADLINE) {
+		if (timerRefresh != NULL)
+			app_timer_cancel(timerRefresh);
+		timerRefresh = NULL;
+		return;
+	}
+
+	uint32_t now = now_ms();
+	uint32_t delay = earliest > now ? earliest - now : 1;
+
+	if (timerRefresh == NULL || !app_timer_reschedule(timerRefresh, delay))
+		timerRefresh = app_timer_register(delay, fire, NULL);
+}
+
+//send every poll due within window ms; returns how many
+static int poll_due(uint32_t window) {
+	uint32_t now = now_ms();
+	int polls = 0;
+
+	//the phone's reply carries the next interval, which schedules the section again
+	outbox_hold();
+	for (int i = 0; i < SM_NUM_SECTIONS; i++) {
+		uint32_t due = deadline(i);
+
+		if (due == NO_DEADLINE || due > now + window)
+			continue;
+
+		if (due > now)
+			stats.bundled++;
+		stats.polls++;
+		polls++;
+		scheduled[i] = NO_DEADLINE;
+		sendCommand(POLL_KEYS[i]);
+	}
+	outbox_release();
+	return polls;
+}
+
+static void fire(void *data) {
+	timerRefresh = NULL;
+	stats.wakeups++;
+
+	poll_due(slack);
+	arm();
+}
+
+
+void refresh_schedule(int section, uint32_t interval_ms) {
+	if (section < 0 || section >= SM_NUM_SECTIONS || POLL_KEYS[section] == 0)
+		return;
+
+	scheduled[section] = now_ms();
+	interval[section] = interval_ms;
+	arm();
+}
+
+void refresh_cancel(int section) {
+	if (section < 0 || section >= SM_NUM_SECTIONS)
+		return;
+
+	scheduled[section] = NO_DEADLINE;
+	arm();
+}
+
+void refresh_set_scale(uint8_t new_scale) {
+	if (new_scale == scale)
+		return;
+	scale = new_scale;
+	arm();
+}
+
+void refresh_suspend(void) {
+	suspended = true;
+	arm();
+}
+
+int refresh_resume(void) {
+	int polls;
+
+	if (!suspended)
+		return 0;
+	suspended = false;
+	polls = poll_due(0);
+	stats.catchups += polls;
+	arm();
+	return polls;
+}
+
+const RefreshStats *refresh_get_stats(void) {
+	return &stats;
+}
+
+void refresh_init(uint32_t slack_ms) {
+	slack = slack_ms;
+	scale = 1;
+	suspended = false;
+	time_ms(&epoch, NULL);
+	for (int i = 0; i < SM_NUM_SECTIONS; i++)
+		scheduled[i] = NO_DEADLINE;
+}
+
+void refresh_deinit(void) {
+	if (timerRefresh != NULL)
+		app_timer_cancel(timerRefresh);
+	timerRefresh = NULL;
+
+	for (int i = 0; i < SM_NUM_SECTIONS; i++)
+		scheduled[i] = NO_DEADLINE;
+}
@@ -0,0 +1,37 @@
+#ifndef _refresh_h
+#define _refresh_h
+
+#include <pebble.h>
+#include "globals.h"
+
+//one timer for all periodic status polls. each section has a deadline; when
+//the earliest one is reached every poll due within the slack window is sent
+//in the same dictionary. the intervals the phone asks for can be stretched
+//(see governor.h) or paused, deadlines move with the scale.
+
+typedef struct {
+	uint32_t wakeups;		//timer callbacks
+	uint32_t polls;			//section polls sent
+	uint32_t bundled;		//polls sent early to share a wakeup
+	uint32_t catchups;		//polls that fell due while suspended
+} RefreshStats;
+
+void refresh_init(uint32_t slack_ms);
+void refresh_deinit(void);
+
+//poll section again in interval_ms, replacing any deadline it had
+void refresh_schedule(int section, uint32_t interval_ms);
+void refresh_cancel(int section);
+
+//multiply every interval by scale; 0 holds all polls until it is set again
+void refresh_set_scale(uint8_t scale);
+
+//no polls and no timer while the screen is covered. resume sends only what
+//fell due meanwhile, without the slack window, in one dictionary and returns
+//how many polls that was.
+void refresh_suspend(void);
+int refresh_resume(void);
+
+const RefreshStats *refresh_get_stats(void);
+
+#endif
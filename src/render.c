@@ -0,0 +1,202 @@
+#include <pebble.h>
+#include "render.h"
+
+enum {RENDER_TEXT, RENDER_HIDDEN, RENDER_BITMAP, RENDER_DIRTY};
+
+typedef struct {
+	void *target;
+	uint8_t op;
+	union {
+		const char *text;
+		const GBitmap *bitmap;
+		bool hidden;
+	};
+} RenderOp;
+
+static RenderOp ops[RENDER_MAX_OPS];
+static int num_ops;
+
+static bool running;
+static bool suspended;				//window covered, nothing is applied
+static bool batch_open;				//a handler staged something and has not committed yet
+static uint32_t batch_requests;		//requests waiting for the next frame
+static uint32_t last_frame_ms;
+static AppTimer *frameTimer = NULL;
+
+static RenderStats stats;
+
+
+static uint32_t now_ms(void) {
+	time_t seconds;
+	uint16_t ms;
+
+	time_ms(&seconds, &ms);
+	return (uint32_t)seconds * 1000 + ms;
+}
+
+static void apply_op(const RenderOp *op) {
+	switch (op->op) {
+		case RENDER_TEXT:
+			text_layer_set_text(op->target, op->text);
+			break;
+		case RENDER_HIDDEN:
+			if (layer_get_hidden(op->target) != op->hidden)
+				layer_set_hidden(op->target, op->hidden);
+			else
+				stats.skipped++;
+			break;
+		case RENDER_BITMAP:
+			bitmap_layer_set_bitmap(op->target, op->bitmap);
+			break;
+		case RENDER_DIRTY:
+			layer_mark_dirty(op->target);
+			break;
+	}
+}
+
+static void apply(void) {
+	if (frameTimer != NULL)
+		app_timer_cancel(frameTimer);
+	frameTimer = NULL;
+
+	for (int i = 0; i < num_ops; i++)
+		apply_op(&ops[i]);
+	num_ops = 0;
+
+	if (batch_requests > 1)
+		stats.saved += batch_requests - 1;
+	batch_requests = 0;
+	stats.frames++;
+	last_frame_ms = now_ms();
+}
+
+static void frame_due(void *data) {
+	frameTimer = NULL;
+	apply();
+}
+
+//the last value staged for a target wins
+static void stage(void *target, uint8_t kind, RenderOp value) {
+	value.target = target;
+	value.op = kind;
+
+	if (!running) {
+		apply_op(&value);
+		return;
+	}
+
+	//a covered window is redrawn in full when it is shown again
+	if (suspended && kind == RENDER_DIRTY) {
+		stats.skipped++;
+		return;
+	}
+
+	if (!batch_open) {
+		batch_open = true;
+		batch_requests++;
+		stats.requests++;
+	}
+
+	for (int i = 0; i < num_ops; i++) {
+		if (ops[i].target == target && ops[i].op == kind) {
+			ops[i] = value;
+			stats.skipped++;
+			return;
+		}
+	}
+
+	if (num_ops == RENDER_MAX_OPS) {
+		if (!suspended) {
+			apply();
+		} else {
+			//covered, so nothing is drawn: the oldest change goes to its layer
+			//without a frame. the status screen has fewer targets than that
+			apply_op(&ops[0]);
+			memmove(&ops[0], &ops[1], (RENDER_MAX_OPS - 1) * sizeof(RenderOp));
+			num_ops--;
+		}
+	}
+	ops[num_ops++] = value;
+}
+
+
+void render_set_text(TextLayer *layer, const char *text) {
+	stage(layer, RENDER_TEXT, (RenderOp){.text = text});
+}
+
+void render_set_hidden(Layer *layer, bool hidden) {
+	stage(layer, RENDER_HIDDEN, (RenderOp){.hidden = hidden});
+}
+
+void render_set_bitmap(BitmapLayer *layer, const GBitmap *bitmap) {
+	stage(layer, RENDER_BITMAP, (RenderOp){.bitmap = bitmap});
+}
+
+void render_mark_dirty(Layer *layer) {
+	stage(layer, RENDER_DIRTY, (RenderOp){.text = NULL});
+}
+
+void render_commit(void) {
+	uint32_t since;
+
+	batch_open = false;
+	if (num_ops == 0 || suspended)
+		return;
+
+	since = now_ms() - last_frame_ms;
+	if (since >= RENDER_FRAME_MS)
+		apply();
+	else if (frameTimer == NULL)
+		frameTimer = app_timer_register(RENDER_FRAME_MS - since, frame_due, NULL);
+}
+
+void render_flush(void) {
+	batch_open = false;
+	if (num_ops > 0 && !suspended)
+		apply();
+}
+
+void render_suspend(void) {
+	int kept = 0;
+
+	if (frameTimer != NULL)
+		app_timer_cancel(frameTimer);
+	frameTimer = NULL;
+	suspended = true;
+
+	//dirty marks are not kept either, the window is redrawn when it is shown
+	for (int i = 0; i < num_ops; i++) {
+		if (ops[i].op != RENDER_DIRTY)
+			ops[kept++] = ops[i];
+		else
+			stats.skipped++;
+	}
+	num_ops = kept;
+}
+
+void render_resume(void) {
+	suspended = false;
+	render_flush();
+}
+
+const RenderStats *render_get_stats(void) {
+	return &stats;
+}
+
+void render_init(void) {
+	running = true;
+	suspended = false;
+	last_frame_ms = now_ms() - RENDER_FRAME_MS;
+}
+
+//layers are about to go away, whatever is staged is dropped
+void render_deinit(void) {
+	if (frameTimer != NULL)
+		app_timer_cancel(frameTimer);
+	frameTimer = NULL;
+	num_ops = 0;
+	batch_open = false;
+	batch_requests = 0;
+	running = false;
+	suspended = false;
+}
@@ -0,0 +1,47 @@
+#ifndef _render_h
+#define _render_h
+
+#include <pebble.h>
+
+//stages UI changes from message handlers and timers and applies them
+//together, at most once per RENDER_FRAME_MS. a burst of messages (a resync
+//after a reconnect sends one per section) then costs one or two frames
+//instead of one each. a change staged twice before it is applied only
+//applies the last value, and hiding a layer that is already hidden is dropped.
+//
+//handlers stage with render_set_*() and finish with render_commit(). input
+//uses render_flush() so a button press never waits. before render_init()
+//and after render_deinit() everything is applied right away.
+
+#define RENDER_FRAME_MS		200
+#define RENDER_MAX_OPS		32
+
+typedef struct {
+	uint32_t requests;		//handler runs that staged something, each would have been a frame
+	uint32_t frames;		//times the staged changes were applied
+	uint32_t saved;			//requests folded into a later frame
+	uint32_t skipped;		//changes overwritten before they were shown, or no-ops
+} RenderStats;
+
+void render_init(void);
+void render_deinit(void);
+
+void render_set_text(TextLayer *layer, const char *text);
+void render_set_hidden(Layer *layer, bool hidden);
+void render_set_bitmap(BitmapLayer *layer, const GBitmap *bitmap);
+void render_mark_dirty(Layer *layer);
+
+//end of a handler: apply now if a frame is due, otherwise when the next one is
+void render_commit(void);
+
+//apply everything staged right now
+void render_flush(void);
+
+//while the window is covered changes are only staged and dirty marks are
+//dropped; resume applies them and the window is redrawn in full
+void render_suspend(void);
+void render_resume(void);
+
+const RenderStats *render_get_stats(void);
+
+#endif
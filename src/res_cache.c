@@ -0,0 +1,108 @@
+#include <pebble.h>
+#include "res_cache.h"
+
+#define RES_CACHE_SLOTS		12
+
+typedef enum {RES_EMPTY, RES_BITMAP, RES_FONT} ResKind;
+
+typedef struct {
+	ResKind kind;
+	uint32_t resource_id;
+	uint16_t refs;
+	union {
+		GBitmap *bitmap;
+		GFont font;
+	};
+} ResEntry;
+
+static ResEntry entries[RES_CACHE_SLOTS];
+
+
+static void entry_free(ResEntry *e) {
+	if (e->kind == RES_BITMAP)
+		gbitmap_destroy(e->bitmap);
+	else if (e->kind == RES_FONT)
+		fonts_unload_custom_font(e->font);
+
+	e->kind = RES_EMPTY;
+	e->refs = 0;
+}
+
+static ResEntry *entry_find(ResKind kind, uint32_t resource_id) {
+	for (int i = 0; i < RES_CACHE_SLOTS; i++) {
+		if (entries[i].kind == kind && entries[i].resource_id == resource_id)
+			return &entries[i];
+	}
+	return NULL;
+}
+
+static ResEntry *entry_alloc(void) {
+	for (int i = 0; i < RES_CACHE_SLOTS; i++) {
+		if (entries[i].kind == RES_EMPTY)
+			return &entries[i];
+	}
+	return NULL;
+}
+
+static ResEntry *acquire(ResKind kind, uint32_t resource_id) {
+	ResEntry *e = entry_find(kind, resource_id);
+
+	if (e == NULL) {
+		e = entry_alloc();
+		if (e == NULL) {
+			APP_LOG(APP_LOG_LEVEL_ERROR, "resource cache full, cannot load %lu", (unsigned long)resource_id);
+			return NULL;
+		}
+
+		if (kind == RES_BITMAP)
+			e->bitmap = gbitmap_create_with_resource(resource_id);
+		else
+			e->font = fonts_load_custom_font(resource_get_handle(resource_id));
+
+		if ((kind == RES_BITMAP && e->bitmap == NULL) || (kind == RES_FONT && e->font == NULL))
+			return NULL;
+
+		e->kind = kind;
+		e->resource_id = resource_id;
+		e->refs = 0;
+	}
+
+	e->refs++;
+	return e;
+}
+
+static void release(ResKind kind, uint32_t resource_id) {
+	ResEntry *e = entry_find(kind, resource_id);
+
+	if (e == NULL || e->refs == 0)
+		return;
+
+	if (--e->refs == 0)
+		entry_free(e);
+}
+
+
+GBitmap *res_bitmap_acquire(uint32_t resource_id) {
+	ResEntry *e = acquire(RES_BITMAP, resource_id);
+	return e ? e->bitmap : NULL;
+}
+
+void res_bitmap_release(uint32_t resource_id) {
+	release(RES_BITMAP, resource_id);
+}
+
+GFont res_font_acquire(uint32_t resource_id) {
+	ResEntry *e = acquire(RES_FONT, resource_id);
+	return e ? e->font : NULL;
+}
+
+void res_font_release(uint32_t resource_id) {
+	release(RES_FONT, resource_id);
+}
+
+void res_cache_deinit(void) {
+	for (int i = 0; i < RES_CACHE_SLOTS; i++) {
+		if (entries[i].kind != RES_EMPTY)
+			entry_free(&entries[i]);
+	}
+}
@@ -0,0 +1,18 @@
+#ifndef _res_cache_h
+#define _res_cache_h
+
+#include <pebble.h>
+
+//reference counted bitmaps and custom fonts, loaded on first use and
+//freed when the last reference is released.
+
+GBitmap *res_bitmap_acquire(uint32_t resource_id);
+void res_bitmap_release(uint32_t resource_id);
+
+GFont res_font_acquire(uint32_t resource_id);
+void res_font_release(uint32_t resource_id);
+
+//frees everything, referenced or not. call once from deinit
+void res_cache_deinit(void);
+
+#endif
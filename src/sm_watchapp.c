@@ -1,73 +1,214 @@
 #include <pebble.h>
 #include "globals.h"
-
-#define STRING_LENGTH 255
-#define NUM_WEATHER_IMAGES	9
-
-enum {CALENDAR_LAYER, MUSIC_LAYER, NUM_LAYERS};
+#include "sm_watchapp.h"
+#include "outbox.h"
+#include "res_cache.h"
+#include "weather_atlas.h"
+#include "clock_face.h"
+#include "gauge.h"
+#include "refresh.h"
+#include "link.h"
+#include "carousel.h"
+#include "bmp_stream.h"
+#include "canvas.h"
+#include "sparkline.h"
+#include "marquee.h"
+#include "debug_stats.h"
+#include "trace.h"
+#include "render.h"
+#include "governor.h"
+
+
+//polls due this close to each other share one wakeup and one message
+#define REFRESH_SLACK_MS	60000
+
+//bottom slot panels, stepped with DOWN. the ones after music stay disabled
+//(and empty) until the phone sends something for them
+enum {CALENDAR_PANEL, MUSIC_PANEL, FORECAST_PANEL, REMINDERS_PANEL, NAV_PANEL, IMAGE_PANEL, CANVAS_PANEL, BITCOIN_PANEL, STOCKS_PANEL, NUM_PANELS};
+
+#define NUM_FORECAST_DAYS	3
+
+//price graphs and their labels, in the protocol's key order
+enum {BITCOIN_GRAPH, STOCKS_GRAPH, NUM_GRAPHS};
+enum {GRAPH_LOW, GRAPH_HIGH, GRAPH_CURR, GRAPH_TITLE, NUM_GRAPH_LABELS};
 
 static void reset();
 
 static Window *window;
 static TextLayer *text_layer;
 
-static PropertyAnimation *ani_out, *ani_in;
-
-static Layer *animated_layer[NUM_LAYERS], *weather_layer;
+static Layer *panel_layer[NUM_PANELS], *weather_layer;
 static Layer *battery_layer, *battery_pbl_layer;
 
-static TextLayer *text_date_layer, *text_time_layer;
+static TextLayer *text_date_layer;
 
 static TextLayer *text_weather_cond_layer, *text_weather_temp_layer, *text_battery_layer;
 static TextLayer *calendar_date_layer, *calendar_text_layer;
 static TextLayer *music_artist_layer, *music_song_layer;
+static Layer *calendar_text_marquee, *music_song_marquee;		//hold the two text layers above
+
+static bool screen_covered;
+static TextLayer *forecast_day_layer[NUM_FORECAST_DAYS], *reminders_layer, *nav_layer;
+static BitmapLayer *forecast_icon_layer[NUM_FORECAST_DAYS];
+static int forecast_img[NUM_FORECAST_DAYS] = {-1, -1, -1};
+static BitmapLayer *stream_image_layer;
+static Layer *canvas_layer;
+static Layer *graph_layer[NUM_GRAPHS];
+static TextLayer *graph_label_layer[NUM_GRAPHS][NUM_GRAPH_LABELS];
  
 static BitmapLayer *background_image, *weather_image, *battery_image_layer, *battery_pbl_image_layer;
 
-static int active_layer;
-
-static char string_buffer[STRING_LENGTH];
-static char weather_cond_str[STRING_LENGTH], weather_temp_str[5];
-static int weather_img, batteryPercent, batteryPblPercent;
+static int weather_img;
+static int last_weather_img = WEATHER_ICON_SUN;		//last icon from the phone, survives disconnects
+
+//every string the phone sends lives in one arena. each field gets the bytes its
+//layer can actually display: layer width over the narrowest glyph (about a quarter
+//of the font size) per line, times the lines that fit, plus an ellipsis and NUL.
+//marquee fields scroll, their width is the widest line a marquee lays out.
+//X(field, layer width, layer height, font size)
+#define TEXT_FIELDS(X) \
+	X(WEATHER_COND,		48,		40,	18) \
+	X(WEATHER_TEMP,		48,		40,	28) \
+	X(CALENDAR_DATE,	132,	21,	18) \
+	X(CALENDAR_TEXT,	MARQUEE_MAX_WIDTH,	28,	24) \
+	X(MUSIC_ARTIST,		132,	21,	18) \
+	X(MUSIC_TITLE,		MARQUEE_MAX_WIDTH,	28,	24) \
+	X(FORECAST_DAY1,	48,		16,	14) \
+	X(FORECAST_DAY2,	48,		16,	14) \
+	X(FORECAST_DAY3,	48,		16,	14) \
+	X(REMINDERS,		132,	42,	18) \
+	X(NAV,				132,	42,	18) \
+	X(BITCOIN_LOW,		34,		16,	14) \
+	X(BITCOIN_HIGH,		34,		16,	14) \
+	X(BITCOIN_CURR,		48,		16,	14) \
+	X(BITCOIN_TITLE,	84,		16,	14) \
+	X(STOCKS_LOW,		34,		16,	14) \
+	X(STOCKS_HIGH,		34,		16,	14) \
+	X(STOCKS_CURR,		48,		16,	14) \
+	X(STOCKS_TITLE,		84,		16,	14)
+
+#define FIELD_LINES(h, font)			((h) / (font) > 0 ? (h) / (font) : 1)
+#define FIELD_BUDGET(w, h, font)		((w) / ((font) / 4) * FIELD_LINES(h, font) + 4)
+
+#define FIELD_ID(name, w, h, font)		FIELD_##name,
+#define FIELD_RANGE(name, w, h, font)	name##_START, name##_END = name##_START + FIELD_BUDGET(w, h, font) - 1,
+#define FIELD_START(name, w, h, font)	name##_START,
+#define FIELD_SIZE(name, w, h, font)	FIELD_BUDGET(w, h, font),
+
+enum {TEXT_FIELDS(FIELD_ID) NUM_FIELDS};
+enum {TEXT_FIELDS(FIELD_RANGE) TEXT_ARENA_SIZE};
+
+static char text_arena[TEXT_ARENA_SIZE];
+static const uint16_t field_start[NUM_FIELDS] = {TEXT_FIELDS(FIELD_START)};
+static const uint8_t field_size[NUM_FIELDS] = {TEXT_FIELDS(FIELD_SIZE)};
+
+#define field_text(field)				(&text_arena[field_start[field]])
+
+#define ELLIPSIS						"\xe2\x80\xa6"
+#define ELLIPSIS_LENGTH					3
+
+
+//last known status, written to flash when it changes and shown at launch
+//before the phone has answered. the text arena is stored as is, the rest
+//goes into a small header.
+#define PERSIST_SNAPSHOT_KEY			1
+#define PERSIST_TEXT_KEY				2
+#define SNAPSHOT_VERSION				2
+
+//generations older than this are not trusted, the phone may have restarted since
+#define SNAPSHOT_FRESH_SECONDS			(30 * 60)
+
+typedef struct {
+	uint8_t version;
+	uint8_t weather_img;
+	int8_t phone_battery;
+	uint8_t has_temp;
+	uint16_t text_size;
+	uint8_t phone_session;
+	uint8_t section_gen[SM_NUM_SECTIONS];
+	uint32_t saved_at;
+} Snapshot;
+
+//only the status fields are kept, they come first in the arena
+#define SNAPSHOT_TEXT_SIZE				(MUSIC_TITLE_END + 1)
+_Static_assert(SNAPSHOT_TEXT_SIZE <= PERSIST_DATA_MAX_LENGTH, "status text does not fit one persist key");
+
+static bool text_dirty, snapshot_dirty;
+
+//the temperature replaces the condition once it arrives. kept here rather than
+//read back from the layer, which may still have a staged change pending.
+static bool temp_shown;
+
+
+
+
+static uint32_t suppressedUpdates = 0;
+
+
+
+//all weather icons are views into one atlas resource, see tools/pack_atlas.py
+static GBitmap *weather_atlas = NULL;
+static GBitmap *weather_icons[NUM_WEATHER_ICONS];
+
+static GBitmap *weather_icon(int icon) {
+	if (weather_icons[icon] == NULL) {
+		if (weather_atlas == NULL)
+			weather_atlas = res_bitmap_acquire(RESOURCE_ID_IMAGE_WEATHER_ATLAS);
+		if (weather_atlas == NULL)
+			return NULL;
+		weather_icons[icon] = gbitmap_create_as_sub_bitmap(weather_atlas, WEATHER_ICON_RECT(icon));
+	}
+	return weather_icons[icon];
+}
 
-static char calendar_date_str[STRING_LENGTH], calendar_text_str[STRING_LENGTH];
-static char music_artist_str1[STRING_LENGTH], music_title_str1[STRING_LENGTH];
+static GBitmap *canvas_bitmap(uint8_t ref) {
+	return ref < NUM_WEATHER_ICONS ? weather_icon(ref) : NULL;
+}
 
+static void set_weather_icon(int img) {
+	if (img == weather_img)
+		return;
 
-GBitmap *bg_image, *battery_image, *battery_pbl_image;
-GBitmap *weather_status_imgs[NUM_WEATHER_IMAGES];
+	weather_img = img;
+	render_set_bitmap(weather_image, weather_icon(img));
+}
 
-static AppTimer *timerUpdateCalendar = NULL;
-static AppTimer *timerUpdateWeather = NULL;
-static AppTimer *timerUpdateMusic = NULL;
 
 
 
-const int WEATHER_IMG_IDS[] = {	
-  RESOURCE_ID_IMAGE_SUN,
-  RESOURCE_ID_IMAGE_RAIN,
-  RESOURCE_ID_IMAGE_CLOUD,
-  RESOURCE_ID_IMAGE_SUN_CLOUD,
-  RESOURCE_ID_IMAGE_FOG,
-  RESOURCE_ID_IMAGE_WIND,
-  RESOURCE_ID_IMAGE_SNOW,
-  RESOURCE_ID_IMAGE_THUNDER,
-  RESOURCE_ID_IMAGE_DISCONNECT
-};
 
+static uint32_t s_sequence_number = 0xFFFFFFFE;
+static uint8_t s_phone_session;
+static uint8_t s_section_gen[SM_NUM_SECTIONS];
 
+//inbound sequencing: when a message carries SM_STATUS_GEN_KEY, a section whose
+//generation equals ours is a retransmit and one a little behind ours is a reply
+//that arrived late. their tuples are skipped before anything is copied. a new
+//phone session means the phone app restarted, every generation we hold is
+//forgotten and the whole message counts as new. a big step back within a
+//session counts as new too.
+#define SEQ_STALE_WINDOW	16
 
+enum {SEQ_NEW, SEQ_DUPLICATE, SEQ_STALE};
 
-static uint32_t s_sequence_number = 0xFFFFFFFE;
+static uint8_t section_seq[SM_NUM_SECTIONS];
+static SequenceStats sequence_stats;
 
 AppMessageResult sm_message_out_get(DictionaryIterator **iter_out) {
     AppMessageResult result = app_message_outbox_begin(iter_out);
     if(result != APP_MSG_OK) return result;
-    dict_write_int32(*iter_out, SM_SEQUENCE_NUMBER_KEY, ++s_sequence_number);
-    if(s_sequence_number == 0xFFFFFFFF) {
+    dict_write_int32(*iter_out, SM_SEQUENCE_NUMBER_KEY, s_sequence_number + 1);
+    //tell the phone which sections we already have, it only sends the ones that changed
+    uint8_t gen[SM_STATUS_GEN_SIZE] = {s_phone_session};
+    memcpy(&gen[1], s_section_gen, sizeof(s_section_gen));
+    dict_write_data(*iter_out, SM_STATUS_GEN_KEY, gen, sizeof(gen));
+    return APP_MSG_OK;
+}
+
+void sm_message_out_sent(void) {
+    if(++s_sequence_number == 0xFFFFFFFF) {
         s_sequence_number = 1;
     }
-    return APP_MSG_OK;
 }
 
 void reset_sequence_number() {
@@ -80,22 +221,14 @@ void reset_sequence_number() {
 
 
 void sendCommand(int key) {
-	DictionaryIterator* iterout;
-	sm_message_out_get(&iterout);
-    if(!iterout) return;
-	
-	dict_write_int8(iterout, key, -1);
-	app_message_outbox_send();
+	TRACE_OUTBOUND(key, -1);
+	outbox_send_command(key, -1);
 }
 
 
 void sendCommandInt(int key, int param) {
-	DictionaryIterator* iterout;
-	sm_message_out_get(&iterout);
-    if(!iterout) return;
-	
-	dict_write_int8(iterout, key, param);
-	app_message_outbox_send();
+	TRACE_OUTBOUND(key, param);
+	outbox_send_command(key, param);
 }
 
 
@@ -104,47 +237,49 @@ void sendCommandInt(int key, int param) {
 
 static void select_click_down_handler(ClickRecognizerRef recognizer, void *context) {
 	//show the weather condition instead of temperature while center button is pressed
-	layer_set_hidden(text_layer_get_layer(text_weather_temp_layer), true);
-	layer_set_hidden(text_layer_get_layer(text_weather_cond_layer), false);
+	render_set_hidden(text_layer_get_layer(text_weather_temp_layer), true);
+	render_set_hidden(text_layer_get_layer(text_weather_cond_layer), false);
+	render_flush();
 }
 
 static void select_click_up_handler(ClickRecognizerRef recognizer, void *context) {
 	//revert to showing the temperature 
-	layer_set_hidden(text_layer_get_layer(text_weather_temp_layer), false);
-	layer_set_hidden(text_layer_get_layer(text_weather_cond_layer), true);
+	render_set_hidden(text_layer_get_layer(text_weather_temp_layer), false);
+	render_set_hidden(text_layer_get_layer(text_weather_cond_layer), true);
+	render_flush();
 }
 
 
 static void up_click_handler(ClickRecognizerRef recognizer, void *context) {
+	TRACE_BUTTON(BUTTON_ID_UP);
+
 	//update all data
 	reset();
+	render_flush();
 	
 	sendCommandInt(SM_SCREEN_ENTER_KEY, STATUS_SCREEN_APP);
 }
 
-static void down_click_handler(ClickRecognizerRef recognizer, void *context) {
-	//slide layers in/out
-
-	property_animation_destroy((PropertyAnimation*)ani_in);
-	property_animation_destroy((PropertyAnimation*)ani_out);
-
+//only the marquees of the panel on screen scroll, and only while the governor allows it
+static void panel_shown(int panel) {
+	bool animate = governor_get_policy()->animate && !screen_covered;
 
-	ani_out = property_animation_create_layer_frame(animated_layer[active_layer], &GRect(0, 124, 143, 45), &GRect(-138, 124, 143, 45));
-	animation_schedule((Animation*)ani_out);
-
-
-	active_layer = (active_layer + 1) % (NUM_LAYERS);
-
-	ani_in = property_animation_create_layer_frame(animated_layer[active_layer], &GRect(138, 124, 144, 45), &GRect(0, 124, 144, 45));
-	animation_schedule((Animation*)ani_in);
+	marquee_set_visible(calendar_text_marquee, animate && panel == CALENDAR_PANEL);
+	marquee_set_visible(music_song_marquee, animate && panel == MUSIC_PANEL);
+}
 
+static void down_click_handler(ClickRecognizerRef recognizer, void *context) {
+	TRACE_BUTTON(BUTTON_ID_DOWN);
 
+	//slide to the next panel; presses during a slide are folded into it
+	carousel_next();
 }
 
 static void click_config_provider(void *context) {
   window_raw_click_subscribe(BUTTON_ID_SELECT, select_click_down_handler, select_click_up_handler, context);
   window_single_click_subscribe(BUTTON_ID_UP, up_click_handler);
   window_single_click_subscribe(BUTTON_ID_DOWN, down_click_handler);
+  DEBUG_CLICK_SUBSCRIBE(BUTTON_ID_DOWN);
 }
 
 static void window_load(Window *window) {
@@ -153,115 +288,174 @@ static void window_load(Window *window) {
 
 }
 
+//only leaving the stack closes the status screen, a window on top just covers it
 static void window_unload(Window *window) {
-	
-	
+	sendCommandInt(SM_SCREEN_EXIT_KEY, STATUS_SCREEN_APP);
 }
 
+//the first appear asks for the full status. after a notification or another
+//window covered the screen only the polls that fell due meanwhile are sent,
+//the rest of the status is still current.
 static void window_appear(Window *window)
 {
-	sendCommandInt(SM_SCREEN_ENTER_KEY, STATUS_SCREEN_APP);
-	  
+	if (!screen_covered) {
+		sendCommandInt(SM_SCREEN_ENTER_KEY, STATUS_SCREEN_APP);
+		return;
+	}
+
+	screen_covered = false;
+	render_resume();
+	refresh_resume();
+	panel_shown(carousel_active());
 }
 
 
+//no polls, frames or scrolling while covered. the phone is not told, it keeps
+//the screen open so appear needs no resync
 static void window_disappear(Window *window)
 {
-	sendCommandInt(SM_SCREEN_EXIT_KEY, STATUS_SCREEN_APP);
-	
-/*
-	app_timer_cancel_event(g_app_context, timerUpdateCalendar);
-	app_timer_cancel_event(g_app_context, timerUpdateMusic);
-	app_timer_cancel_event(g_app_context, timerUpdateWeather);
-*/	
+	screen_covered = true;
+	refresh_suspend();
+	render_suspend();
+	panel_shown(carousel_active());
 }
 
 
-void battery_layer_update_callback(Layer *me, GContext* ctx) {
-	
-	//draw the remaining battery percentage
-	graphics_context_set_stroke_color(ctx, GColorBlack);
-	graphics_context_set_fill_color(ctx, GColorWhite);
 
-	graphics_fill_rect(ctx, GRect(2+16-(int)((batteryPercent/100.0)*16.0), 2, (int)((batteryPercent/100.0)*16.0), 8), 0, GCornerNone);
-	
+static void snapshot_save(void) {
+	Snapshot snapshot = {
+		.version = SNAPSHOT_VERSION,
+		.weather_img = last_weather_img,
+		.phone_battery = gauge_get_level(battery_layer),
+		.has_temp = temp_shown,
+		.text_size = SNAPSHOT_TEXT_SIZE,
+		.saved_at = time(NULL)
+	};
+
+	snapshot.phone_session = s_phone_session;
+	memcpy(snapshot.section_gen, s_section_gen, sizeof(snapshot.section_gen));
+
+	if (text_dirty)
+		persist_write_data(PERSIST_TEXT_KEY, text_arena, SNAPSHOT_TEXT_SIZE);
+	persist_write_data(PERSIST_SNAPSHOT_KEY, &snapshot, sizeof(snapshot));
+
+	text_dirty = false;
+	snapshot_dirty = false;
 }
 
-void battery_pbl_layer_update_callback(Layer *me, GContext* ctx) {
-	
-	//draw the remaining pebble battery percentage
-	graphics_context_set_stroke_color(ctx, GColorBlack);
-	graphics_context_set_fill_color(ctx, GColorWhite);
+static void restore_field(TextLayer *layer, int field) {
+	if (field_text(field)[0] != '\0')
+		text_layer_set_text(layer, field_text(field));
+}
 
-	graphics_fill_rect(ctx, GRect(2+16-(int)((batteryPblPercent/100.0)*16.0), 2, (int)((batteryPblPercent/100.0)*16.0), 8), 0, GCornerNone);
-	
+//called from init once the layers exist, before the first frame
+static void snapshot_restore(void) {
+	Snapshot snapshot;
+
+	if (persist_read_data(PERSIST_SNAPSHOT_KEY, &snapshot, sizeof(snapshot)) != sizeof(snapshot)
+			|| snapshot.version != SNAPSHOT_VERSION || snapshot.text_size != SNAPSHOT_TEXT_SIZE)
+		return;
+	if (persist_read_data(PERSIST_TEXT_KEY, text_arena, SNAPSHOT_TEXT_SIZE) != SNAPSHOT_TEXT_SIZE) {
+		memset(text_arena, 0, SNAPSHOT_TEXT_SIZE);
+		return;
+	}
+	text_arena[SNAPSHOT_TEXT_SIZE - 1] = '\0';
+
+	restore_field(text_weather_cond_layer, FIELD_WEATHER_COND);
+	restore_field(text_weather_temp_layer, FIELD_WEATHER_TEMP);
+	restore_field(calendar_date_layer, FIELD_CALENDAR_DATE);
+	restore_field(calendar_text_layer, FIELD_CALENDAR_TEXT);
+	restore_field(music_artist_layer, FIELD_MUSIC_ARTIST);
+	restore_field(music_song_layer, FIELD_MUSIC_TITLE);
+	marquee_text_changed(calendar_text_marquee, text_layer_get_text(calendar_text_layer));
+	marquee_text_changed(music_song_marquee, text_layer_get_text(music_song_layer));
+
+	if (snapshot.has_temp && field_text(FIELD_WEATHER_TEMP)[0] != '\0') {
+		temp_shown = true;
+		layer_set_hidden(text_layer_get_layer(text_weather_cond_layer), true);
+		layer_set_hidden(text_layer_get_layer(text_weather_temp_layer), false);
+	}
+
+	if (snapshot.weather_img < NUM_WEATHER_ICONS) {
+		last_weather_img = snapshot.weather_img;
+		if (weather_img != WEATHER_ICON_DISCONNECT)
+			set_weather_icon(last_weather_img);
+	}
+	if (snapshot.phone_battery >= 0)
+		gauge_set_level(battery_layer, snapshot.phone_battery, false, false);
+
+	//still fresh: the phone only needs to send what changed since
+	if ((uint32_t)time(NULL) - snapshot.saved_at < SNAPSHOT_FRESH_SECONDS) {
+		s_phone_session = snapshot.phone_session;
+		memcpy(s_section_gen, snapshot.section_gen, sizeof(s_section_gen));
+	}
 }
 
 
 void reset() {
 	
-	layer_set_hidden(text_layer_get_layer(text_weather_temp_layer), true);
-	layer_set_hidden(text_layer_get_layer(text_weather_cond_layer), false);
-	text_layer_set_text(text_weather_cond_layer, "Updating..."); 	
+	//the weather text is replaced below, so ask the phone for the weather section again
+	s_section_gen[SM_SECTION_WEATHER] = 0;
+
+	temp_shown = false;
+	render_set_hidden(text_layer_get_layer(text_weather_temp_layer), true);
+	render_set_hidden(text_layer_get_layer(text_weather_cond_layer), false);
+	render_set_text(text_weather_cond_layer, "Updating..."); 	
 	
 }
 
 
 void handle_minute_tick(struct tm *tick_time, TimeUnits units_changed) {
-  // Need to be static because they're used by the system later.
-  static char time_text[] = "00:00";
+  // Need to be static because it's used by the system later.
   static char date_text[] = "Xxxxxxxxx 00";
+  DEBUG_BEGIN(start);
 
-  char *time_format;
-
-
-  // TODO: Only update the date when it's changed.
-  strftime(date_text, sizeof(date_text), "%a, %b %e", tick_time);
-  text_layer_set_text(text_date_layer, date_text);
-
-
-  if (clock_is_24h_style()) {
-    time_format = "%R";
-  } else {
-    time_format = "%I:%M";
+  if (units_changed & DAY_UNIT) {
+    strftime(date_text, sizeof(date_text), "%a, %b %e", tick_time);
+    render_set_text(text_date_layer, date_text);
   }
 
-  strftime(time_text, sizeof(time_text), time_format, tick_time);
+  clock_face_update(tick_time);
 
-  // Kludge to handle lack of non-padded hour format string
-  // for twelve hour clock.
-  if (!clock_is_24h_style() && (time_text[0] == '0')) {
-    memmove(time_text, &time_text[1], sizeof(time_text) - 1);
-  }
-
-  text_layer_set_text(text_time_layer, time_text);
+  //there is a frame now anyway, anything staged goes with it. while covered
+  //the time is only staged and shown on appear
+  render_flush();
+  DEBUG_END(DEBUG_TICK, start);
 }
 
 
-void reconnect(void *data) {
+//link has been stable for a while, ask for everything again
+void reconnect(void) {
 	reset();
 
 	sendCommandInt(SM_SCREEN_ENTER_KEY, STATUS_SCREEN_APP);
-	
+	render_commit();
 }
 
-void bluetoothChanged(bool connected) {
+void link_lost(void) {
+	set_weather_icon(WEATHER_ICON_DISCONNECT);
+	vibes_double_pulse();
+	render_commit();
+}
 
-	if (connected) {
-		app_timer_register(5000, reconnect, NULL);
-	} else {
-		bitmap_layer_set_bitmap(weather_image, weather_status_imgs[NUM_WEATHER_IMAGES-1]);
-		vibes_double_pulse();
-	}
-	
+void bluetoothChanged(bool connected) {
+	TRACE_CONNECTION(connected);
+	outbox_connection_changed(connected);
+	link_connection_changed(connected);
 }
 
 
 void batteryChanged(BatteryChargeState batt) {
 	
-	batteryPblPercent = batt.charge_percent;
-	layer_mark_dirty(battery_layer);
-	
+	gauge_set_level(battery_pbl_layer, batt.charge_percent, batt.is_charging, batt.is_plugged);
+	governor_battery_changed(batt);
+	render_commit();
+}
+
+static void policy_changed(const GovernorPolicy *policy) {
+	refresh_set_scale(policy->poll_scale);
+	carousel_set_animated(policy->animate);
+	panel_shown(carousel_active());
 }
 
 
@@ -278,13 +472,6 @@ static void init(void) {
   const bool animated = true;
   window_stack_push(window, animated);
 
-	//init weather images
-	for (int i=0; i<NUM_WEATHER_IMAGES; i++) {
-	  	weather_status_imgs[i] = gbitmap_create_with_resource(WEATHER_IMG_IDS[i]);
-	}
-	
-  	bg_image = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_BACKGROUND);
-
 
   	Layer *window_layer = window_get_root_layer(window);
 
@@ -293,23 +480,20 @@ static void init(void) {
 
 	background_image = bitmap_layer_create(bg_bounds);
 	layer_add_child(window_layer, bitmap_layer_get_layer(background_image));
-	bitmap_layer_set_bitmap(background_image, bg_image);
+	bitmap_layer_set_bitmap(background_image, res_bitmap_acquire(RESOURCE_ID_IMAGE_BACKGROUND));
 	
 
 	//init weather layer and add weather image, weather condition, temperature, and battery indicator
 	weather_layer = layer_create(GRect(0, 78, 144, 45));
 	layer_add_child(window_layer, weather_layer);
 
-	battery_image = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_BATTERY_PHONE);
-	battery_pbl_image = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_BATTERY_PEBBLE);
-
 	battery_image_layer = bitmap_layer_create(GRect(100, 7, 37, 14));
 	layer_add_child(weather_layer, bitmap_layer_get_layer(battery_image_layer));
-	bitmap_layer_set_bitmap(battery_image_layer, battery_image);
+	bitmap_layer_set_bitmap(battery_image_layer, res_bitmap_acquire(RESOURCE_ID_IMAGE_BATTERY_PHONE));
 
 	battery_pbl_image_layer = bitmap_layer_create(GRect(100, 23, 37, 14));
 	layer_add_child(weather_layer, bitmap_layer_get_layer(battery_pbl_image_layer));
-	bitmap_layer_set_bitmap(battery_pbl_image_layer, battery_pbl_image);
+	bitmap_layer_set_bitmap(battery_pbl_image_layer, res_bitmap_acquire(RESOURCE_ID_IMAGE_BATTERY_PEBBLE));
 
 
 	text_battery_layer = text_layer_create(GRect(99, 20, 40, 60));
@@ -322,20 +506,17 @@ static void init(void) {
 	layer_set_hidden(text_layer_get_layer(text_battery_layer), true);
 
 
-	battery_layer = layer_create(GRect(102, 8, 19, 11));
-	layer_set_update_proc(battery_layer, battery_layer_update_callback);
+	//phone gauge starts full; its label is set by the first SM_COUNT_BATTERY_KEY
+	battery_layer = gauge_create(GRect(102, 8, 19, 11));
 	layer_add_child(weather_layer, battery_layer);
+	gauge_set_level(battery_layer, 100, false, false);
+	gauge_set_label(battery_layer, text_battery_layer);
 
-	batteryPercent = 100;
-	layer_mark_dirty(battery_layer);
-
-	battery_pbl_layer = layer_create(GRect(102, 24, 19, 11));
-	layer_set_update_proc(battery_pbl_layer, battery_pbl_layer_update_callback);
+	battery_pbl_layer = gauge_create(GRect(102, 24, 19, 11));
 	layer_add_child(weather_layer, battery_pbl_layer);
 
 	BatteryChargeState pbl_batt = battery_state_service_peek();
-	batteryPblPercent = pbl_batt.charge_percent;
-	layer_mark_dirty(battery_pbl_layer);
+	gauge_set_level(battery_pbl_layer, pbl_batt.charge_percent, pbl_batt.is_charging, pbl_batt.is_plugged);
 
 
 	text_weather_cond_layer = text_layer_create(GRect(48, 1, 48, 40)); // GRect(5, 2, 47, 40)
@@ -348,16 +529,16 @@ static void init(void) {
 	layer_set_hidden(text_layer_get_layer(text_weather_cond_layer), false);
 	text_layer_set_text(text_weather_cond_layer, "Updating..."); 	
 	
+	weather_image = bitmap_layer_create(GRect(5, 2, 40, 40)); 
+	layer_add_child(weather_layer, bitmap_layer_get_layer(weather_image));
+
+	weather_img = -1;
 	if (bluetooth_connection_service_peek()) {
-		weather_img = 0;
+		set_weather_icon(WEATHER_ICON_SUN);
 	} else {
-		weather_img = NUM_WEATHER_IMAGES - 1;
+		set_weather_icon(WEATHER_ICON_DISCONNECT);
 	}
 
-	weather_image = bitmap_layer_create(GRect(5, 2, 40, 40)); 
-	layer_add_child(weather_layer, bitmap_layer_get_layer(weather_image));
-	bitmap_layer_set_bitmap(weather_image, weather_status_imgs[weather_img]);
-
 
 	text_weather_temp_layer = text_layer_create(GRect(48, 3, 48, 40)); 
 	text_layer_set_text_alignment(text_weather_temp_layer, GTextAlignmentCenter);
@@ -376,94 +557,111 @@ static void init(void) {
 	text_layer_set_text_color(text_date_layer, GColorWhite);
 	text_layer_set_background_color(text_date_layer, GColorClear);
 	layer_set_frame(text_layer_get_layer(text_date_layer), GRect(0, 45, 144, 30));
-	text_layer_set_font(text_date_layer, fonts_load_custom_font(resource_get_handle(RESOURCE_ID_FONT_ROBOTO_CONDENSED_21)));
+	text_layer_set_font(text_date_layer, res_font_acquire(RESOURCE_ID_FONT_ROBOTO_CONDENSED_21));
 	layer_add_child(window_layer, text_layer_get_layer(text_date_layer));
 
 
-	text_time_layer = text_layer_create(bg_bounds);
-	text_layer_set_text_alignment(text_time_layer, GTextAlignmentCenter);
-	text_layer_set_text_color(text_time_layer, GColorWhite);
-	text_layer_set_background_color(text_time_layer, GColorClear);
-	layer_set_frame(text_layer_get_layer(text_time_layer), GRect(0, -5, 144, 50));
-	text_layer_set_font(text_time_layer, fonts_load_custom_font(resource_get_handle(RESOURCE_ID_FONT_ROBOTO_BOLD_SUBSET_49)));
-	layer_add_child(window_layer, text_layer_get_layer(text_time_layer));
+	clock_face_init(window_layer, GRect(0, -5, 144, 50), res_font_acquire(RESOURCE_ID_FONT_ROBOTO_BOLD_SUBSET_49));
+
+
+	//init bottom slot carousel; panel contents after music are built when their data arrives
+	carousel_init(window_layer, GRect(0, 124, 144, 45));
+	panel_layer[CALENDAR_PANEL] = carousel_add_panel(true);
+	panel_layer[MUSIC_PANEL] = carousel_add_panel(true);
+	panel_layer[FORECAST_PANEL] = carousel_add_panel(false);
+	panel_layer[REMINDERS_PANEL] = carousel_add_panel(false);
+	panel_layer[NAV_PANEL] = carousel_add_panel(false);
+	panel_layer[IMAGE_PANEL] = carousel_add_panel(false);
+	panel_layer[CANVAS_PANEL] = carousel_add_panel(false);
+	panel_layer[BITCOIN_PANEL] = carousel_add_panel(false);
+	panel_layer[STOCKS_PANEL] = carousel_add_panel(false);
 
+	//images pushed by the phone are decoded into one bitmap the size of the slot
+	bmp_stream_init(GSize(144, 45));
+
+	//panels drawn from a command list the phone sends; bitmap refs are weather icons
+	canvas_init(canvas_bitmap);
 
 	//init calendar layer
-	animated_layer[CALENDAR_LAYER] = layer_create(GRect(0, 124, 144, 45));
-	layer_add_child(window_layer, animated_layer[CALENDAR_LAYER]);
 	
 	calendar_date_layer = text_layer_create(GRect(6, 0, 132, 21));
 	text_layer_set_text_alignment(calendar_date_layer, GTextAlignmentLeft);
 	text_layer_set_text_color(calendar_date_layer, GColorWhite);
 	text_layer_set_background_color(calendar_date_layer, GColorClear);
 	text_layer_set_font(calendar_date_layer, fonts_get_system_font(FONT_KEY_GOTHIC_18));
-	layer_add_child(animated_layer[CALENDAR_LAYER], text_layer_get_layer(calendar_date_layer));
+	layer_add_child(panel_layer[CALENDAR_PANEL], text_layer_get_layer(calendar_date_layer));
 	text_layer_set_text(calendar_date_layer, "No Upcoming"); 	
 
 
-	calendar_text_layer = text_layer_create(GRect(6, 15, 132, 28));
-	text_layer_set_text_alignment(calendar_text_layer, GTextAlignmentLeft);
-	text_layer_set_text_color(calendar_text_layer, GColorWhite);
-	text_layer_set_background_color(calendar_text_layer, GColorClear);
-	text_layer_set_font(calendar_text_layer, fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD));
-	layer_add_child(animated_layer[CALENDAR_LAYER], text_layer_get_layer(calendar_text_layer));
+	//long subjects and titles scroll instead of being cut at the panel edge
+	calendar_text_marquee = marquee_create(GRect(6, 15, 132, 28), fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD));
+	calendar_text_layer = marquee_get_text_layer(calendar_text_marquee);
+	layer_add_child(panel_layer[CALENDAR_PANEL], calendar_text_marquee);
 	text_layer_set_text(calendar_text_layer, "Appointment");
 	
 	
 	
 	//init music layer
-	animated_layer[MUSIC_LAYER] = layer_create(GRect(144, 124, 144, 45));
-	layer_add_child(window_layer, animated_layer[MUSIC_LAYER]);
 	
 	music_artist_layer = text_layer_create(GRect(6, 0, 132, 21));
 	text_layer_set_text_alignment(music_artist_layer, GTextAlignmentLeft);
 	text_layer_set_text_color(music_artist_layer, GColorWhite);
 	text_layer_set_background_color(music_artist_layer, GColorClear);
 	text_layer_set_font(music_artist_layer, fonts_get_system_font(FONT_KEY_GOTHIC_18));
-	layer_add_child(animated_layer[MUSIC_LAYER], text_layer_get_layer(music_artist_layer));
+	layer_add_child(panel_layer[MUSIC_PANEL], text_layer_get_layer(music_artist_layer));
 	text_layer_set_text(music_artist_layer, "Artist"); 	
 
 
-	music_song_layer = text_layer_create(GRect(6, 15, 132, 28));
-	text_layer_set_text_alignment(music_song_layer, GTextAlignmentLeft);
-	text_layer_set_text_color(music_song_layer, GColorWhite);
-	text_layer_set_background_color(music_song_layer, GColorClear);
-	text_layer_set_font(music_song_layer, fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD));
-	layer_add_child(animated_layer[MUSIC_LAYER], text_layer_get_layer(music_song_layer));
+	music_song_marquee = marquee_create(GRect(6, 15, 132, 28), fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD));
+	music_song_layer = marquee_get_text_layer(music_song_marquee);
+	marquee_set_visible(music_song_marquee, false);
+	layer_add_child(panel_layer[MUSIC_PANEL], music_song_marquee);
 	text_layer_set_text(music_song_layer, "Title");
 
+	carousel_set_shown_handler(panel_shown);
 
-	active_layer = CALENDAR_LAYER;
 
 	reset();
+	snapshot_restore();
+
+	//everything above is on the first frame; from here on UI changes are staged
+	render_init();
+
+	refresh_init(REFRESH_SLACK_MS);
 
   	tick_timer_service_subscribe(MINUTE_UNIT, handle_minute_tick);
 
+	//the first tick is up to a minute away, show the time and date right now
+	time_t now = time(NULL);
+	handle_minute_tick(localtime(&now), MINUTE_UNIT | HOUR_UNIT | DAY_UNIT);
+
+	link_init(bluetooth_connection_service_peek(), (LinkHandlers) {
+		.lost = link_lost,
+		.resync = reconnect,
+		.changed = governor_link_changed
+	});
+	governor_init(battery_state_service_peek(), link_get_state(), policy_changed);
+
 	bluetooth_connection_service_subscribe(bluetoothChanged);
 	battery_state_service_subscribe(batteryChanged);
 
+	DEBUG_INIT(window);
+
 }
 
 static void deinit(void) {
 	
 	
-	property_animation_destroy((PropertyAnimation*)ani_in);
-	property_animation_destroy((PropertyAnimation*)ani_out);
 	
 
 	
-	if (timerUpdateCalendar != NULL)
-		app_timer_cancel(timerUpdateCalendar);
-	timerUpdateCalendar = NULL;
+	//off the stack first, so disappear and unload run while the layers still exist
+	window_stack_remove(window, false);
 
-	if (timerUpdateWeather != NULL)	
-		app_timer_cancel(timerUpdateWeather);
-	timerUpdateWeather = NULL;
-	
-	if (timerUpdateMusic != NULL)
-		app_timer_cancel(timerUpdateMusic);
-	timerUpdateMusic = NULL;
+	governor_deinit();
+	refresh_deinit();
+	link_deinit();
+	render_deinit();
 	
 
 
@@ -472,164 +670,523 @@ static void deinit(void) {
 	bitmap_layer_destroy(battery_image_layer);
 	bitmap_layer_destroy(battery_pbl_image_layer);
 	text_layer_destroy(text_battery_layer);
-	layer_destroy(battery_layer);
-	layer_destroy(battery_pbl_layer);
+	gauge_destroy(battery_layer);
+	gauge_destroy(battery_pbl_layer);
 	text_layer_destroy(text_weather_cond_layer);
 	bitmap_layer_destroy(weather_image);
 	text_layer_destroy(text_weather_temp_layer);
 	text_layer_destroy(text_date_layer);
-	text_layer_destroy(text_time_layer);
+	clock_face_deinit();
 	text_layer_destroy(calendar_date_layer);
-	text_layer_destroy(calendar_text_layer);
+	marquee_destroy(calendar_text_marquee);
 	text_layer_destroy(music_artist_layer);
-	text_layer_destroy(music_song_layer);
+	marquee_destroy(music_song_marquee);
 	
 
-	for (int i=0; i<NUM_LAYERS; i++) {
-		if (animated_layer[i]!=NULL)
-			layer_destroy(animated_layer[i]);
+	for (int i=0; i<NUM_FORECAST_DAYS; i++) {
+		if (forecast_day_layer[i] != NULL)
+			text_layer_destroy(forecast_day_layer[i]);
+		if (forecast_icon_layer[i] != NULL)
+			bitmap_layer_destroy(forecast_icon_layer[i]);
 	}
-
-	for (int i=0; i<NUM_WEATHER_IMAGES; i++) {
-	  	gbitmap_destroy(weather_status_imgs[i]);
+	if (reminders_layer != NULL)
+		text_layer_destroy(reminders_layer);
+	if (nav_layer != NULL)
+		text_layer_destroy(nav_layer);
+	if (stream_image_layer != NULL)
+		bitmap_layer_destroy(stream_image_layer);
+	bmp_stream_deinit();
+	if (canvas_layer != NULL)
+		layer_destroy(canvas_layer);
+	for (int i=0; i<NUM_GRAPHS; i++) {
+		if (graph_layer[i] == NULL)
+			continue;
+		sparkline_destroy(graph_layer[i]);
+		for (int j=0; j<NUM_GRAPH_LABELS; j++)
+			text_layer_destroy(graph_label_layer[i][j]);
 	}
-	
 
-	gbitmap_destroy(bg_image);
-	gbitmap_destroy(battery_image);
-	gbitmap_destroy(battery_pbl_image);
+	carousel_deinit();
+
+	for (int i=0; i<NUM_WEATHER_ICONS; i++) {
+		if (weather_icons[i] != NULL)
+			gbitmap_destroy(weather_icons[i]);
+		weather_icons[i] = NULL;
+	}
+	if (weather_atlas != NULL)
+		res_bitmap_release(RESOURCE_ID_IMAGE_WEATHER_ATLAS);
+	weather_atlas = NULL;
+	res_bitmap_release(RESOURCE_ID_IMAGE_BACKGROUND);
+	res_bitmap_release(RESOURCE_ID_IMAGE_BATTERY_PHONE);
+	res_bitmap_release(RESOURCE_ID_IMAGE_BATTERY_PEBBLE);
+	res_font_release(RESOURCE_ID_FONT_ROBOTO_CONDENSED_21);
+	res_font_release(RESOURCE_ID_FONT_ROBOTO_BOLD_SUBSET_49);
+	res_cache_deinit();
 
 
 	tick_timer_service_unsubscribe();
 	bluetooth_connection_service_unsubscribe();
 	battery_state_service_unsubscribe();
 
+	DEBUG_DEINIT();
   
   window_destroy(window);
 }
 
 
-static void updateWeather(void *data) {
-	sendCommand(SM_STATUS_UPD_WEATHER_KEY);	
+//copy a string tuple into its arena field. text that does not fit is cut at a
+//UTF-8 character boundary and gets an ellipsis. returns false if the field
+//already held exactly that text
+static bool tuple_copy_field(int field, const Tuple *t) {
+	char *dest = field_text(field);
+	size_t size = field_size[field];
+	const char *src = t->value->cstring;
+	size_t len = 0, cut;
+	bool ellipsis = false;
+
+	if (t->type == TUPLE_CSTRING || t->type == TUPLE_BYTE_ARRAY) {
+		const char *nul = memchr(src, '\0', t->length);
+		len = nul ? (size_t)(nul - src) : t->length;
+	}
+
+	cut = len;
+	if (len > size - 1) {
+		cut = size - 1 - ELLIPSIS_LENGTH;
+		while (cut > 0 && (src[cut] & 0xC0) == 0x80)
+			cut--;
+		ellipsis = true;
+	}
+
+	if (memcmp(dest, src, cut) == 0
+			&& (ellipsis ? memcmp(dest + cut, ELLIPSIS, ELLIPSIS_LENGTH + 1) == 0 : dest[cut] == '\0'))
+		return false;
+
+	memcpy(dest, src, cut);
+	if (ellipsis) {
+		memcpy(dest + cut, ELLIPSIS, ELLIPSIS_LENGTH);
+		cut += ELLIPSIS_LENGTH;
+	}
+	dest[cut] = '\0';
+	return true;
 }
 
-static void updateCalendar(void *data) {
-	sendCommand(SM_STATUS_UPD_CAL_KEY);	
+//only touch the layer if the text changed or the layer is showing a placeholder;
+//returns true when the layer gets the field's text
+static bool set_text_if_changed(TextLayer *layer, int field, const Tuple *t) {
+	bool changed = tuple_copy_field(field, t);
+
+	if (changed || text_layer_get_text(layer) != field_text(field)) {
+		if (changed && field_start[field] < SNAPSHOT_TEXT_SIZE)
+			text_dirty = snapshot_dirty = true;
+		render_set_text(layer, field_text(field));
+		return true;
+	}
+	suppressedUpdates++;
+	return false;
 }
 
-static void updateMusic(void *data) {
-	sendCommand(SM_SONG_LENGTH_KEY);	
+uint32_t sm_suppressed_updates(void) {
+	return suppressedUpdates;
 }
 
+//integer tuples can arrive as 1, 2 or 4 bytes, signed or unsigned
+static int32_t tuple_int(const Tuple *t) {
+	bool is_signed = (t->type == TUPLE_INT);
 
-void rcv(DictionaryIterator *received, void *context) {
-	// Got a message callback
-	Tuple *t;
+	switch (t->length) {
+		case 1: return is_signed ? t->value->int8 : t->value->uint8;
+		case 2: return is_signed ? t->value->int16 : t->value->uint16;
+		case 4: return t->value->int32;
+		default: return 0;
+	}
+}
 
 
-	t=dict_find(received, SM_WEATHER_COND_KEY); 
-	if (t!=NULL) {
-		memcpy(weather_cond_str, t->value->cstring, strlen(t->value->cstring));
-        weather_cond_str[strlen(t->value->cstring)] = '\0';
-		text_layer_set_text(text_weather_cond_layer, weather_cond_str); 	
-	}
+static void rcv_weather_cond(const Tuple *t) {
+	set_text_if_changed(text_weather_cond_layer, FIELD_WEATHER_COND, t);
+}
 
-	t=dict_find(received, SM_WEATHER_TEMP_KEY); 
-	if (t!=NULL) {
-		memcpy(weather_temp_str, t->value->cstring, strlen(t->value->cstring));
-        weather_temp_str[strlen(t->value->cstring)] = '\0';
-		text_layer_set_text(text_weather_temp_layer, weather_temp_str); 
-		
-		layer_set_hidden(text_layer_get_layer(text_weather_cond_layer), true);
-		layer_set_hidden(text_layer_get_layer(text_weather_temp_layer), false);
-			
+static void rcv_weather_temp(const Tuple *t) {
+	set_text_if_changed(text_weather_temp_layer, FIELD_WEATHER_TEMP, t);
+
+	if (!temp_shown) {
+		temp_shown = true;
+		snapshot_dirty = true;
 	}
+	render_set_hidden(text_layer_get_layer(text_weather_cond_layer), true);
+	render_set_hidden(text_layer_get_layer(text_weather_temp_layer), false);
+}
+
+static void rcv_weather_icon(const Tuple *t) {
+	int32_t icon = tuple_int(t);
+
+	if (icon < 0 || icon >= NUM_WEATHER_ICONS)
+		return;
 
-	t=dict_find(received, SM_WEATHER_ICON_KEY); 
-	if (t!=NULL) {
-		bitmap_layer_set_bitmap(weather_image, weather_status_imgs[t->value->uint8]);	  	
+	if (icon == weather_img) {
+		suppressedUpdates++;
+		return;
 	}
+	set_weather_icon(icon);
+	if (icon != last_weather_img) {
+		last_weather_img = icon;
+		snapshot_dirty = true;
+	}
+}
+
+static void rcv_battery(const Tuple *t) {
+	if (!gauge_set_level(battery_layer, tuple_int(t), false, false))
+		suppressedUpdates++;
+	else
+		snapshot_dirty = true;
+}
+
+static void rcv_calendar_time(const Tuple *t) {
+	set_text_if_changed(calendar_date_layer, FIELD_CALENDAR_DATE, t);
+}
 
-	t=dict_find(received, SM_COUNT_BATTERY_KEY); 
-	if (t!=NULL) {
-		batteryPercent = t->value->uint8;
-		layer_mark_dirty(battery_layer);
-		snprintf(string_buffer, sizeof(string_buffer), "%d", batteryPercent);
-		text_layer_set_text(text_battery_layer, string_buffer ); 	
+static void rcv_calendar_text(const Tuple *t) {
+	if (set_text_if_changed(calendar_text_layer, FIELD_CALENDAR_TEXT, t))
+		marquee_text_changed(calendar_text_marquee, field_text(FIELD_CALENDAR_TEXT));
+}
+
+static void rcv_music_artist(const Tuple *t) {
+	set_text_if_changed(music_artist_layer, FIELD_MUSIC_ARTIST, t);
+}
+
+static void rcv_music_title(const Tuple *t) {
+	if (set_text_if_changed(music_song_layer, FIELD_MUSIC_TITLE, t))
+		marquee_text_changed(music_song_marquee, field_text(FIELD_MUSIC_TITLE));
+}
+
+//forecast, reminders and nav panels are only built once the phone sends something for them
+static TextLayer *panel_text_layer(int panel, GRect frame, const char *font_key, GTextAlignment alignment) {
+	TextLayer *layer = text_layer_create(frame);
+
+	text_layer_set_text_alignment(layer, alignment);
+	text_layer_set_text_color(layer, GColorWhite);
+	text_layer_set_background_color(layer, GColorClear);
+	text_layer_set_font(layer, fonts_get_system_font(font_key));
+	layer_add_child(panel_layer[panel], text_layer_get_layer(layer));
+	return layer;
+}
+
+static void build_forecast_panel(void) {
+	if (forecast_day_layer[0] != NULL)
+		return;
+
+	for (int i=0; i<NUM_FORECAST_DAYS; i++) {
+		forecast_icon_layer[i] = bitmap_layer_create(GRect(i * 48 + 4, 0, WEATHER_ICON_W, WEATHER_ICON_H));
+		layer_add_child(panel_layer[FORECAST_PANEL], bitmap_layer_get_layer(forecast_icon_layer[i]));
+
+		//label sits on a black strip over the bottom of the icon
+		forecast_day_layer[i] = panel_text_layer(FORECAST_PANEL, GRect(i * 48, 28, 48, 17), FONT_KEY_GOTHIC_14_BOLD, GTextAlignmentCenter);
+		text_layer_set_background_color(forecast_day_layer[i], GColorBlack);
 	}
+	carousel_set_enabled(FORECAST_PANEL, true);
+}
 
-	t=dict_find(received, SM_STATUS_CAL_TIME_KEY); 
-	if (t!=NULL) {
-		memcpy(calendar_date_str, t->value->cstring, strlen(t->value->cstring));
-        calendar_date_str[strlen(t->value->cstring)] = '\0';				
-		text_layer_set_text(calendar_date_layer, calendar_date_str); 	
+static void rcv_forecast_day(const Tuple *t) {
+	int day = t->key - SM_WEATHER_DAY1_KEY;
+
+	build_forecast_panel();
+	set_text_if_changed(forecast_day_layer[day], FIELD_FORECAST_DAY1 + day, t);
+}
+
+static void rcv_forecast_icon(const Tuple *t) {
+	int day = t->key - SM_WEATHER_ICON1_KEY;
+	int32_t icon = tuple_int(t);
+
+	if (icon < 0 || icon >= NUM_WEATHER_ICONS)
+		return;
+
+	build_forecast_panel();
+	if (icon == forecast_img[day]) {
+		suppressedUpdates++;
+		return;
 	}
+	forecast_img[day] = icon;
+	render_set_bitmap(forecast_icon_layer[day], weather_icon(icon));
+}
 
-	t=dict_find(received, SM_STATUS_CAL_TEXT_KEY); 
-	if (t!=NULL) {
-		memcpy(calendar_text_str, t->value->cstring, strlen(t->value->cstring));
-        calendar_text_str[strlen(t->value->cstring)] = '\0';
-		text_layer_set_text(calendar_text_layer, calendar_text_str); 	
+static void rcv_reminders(const Tuple *t) {
+	if (reminders_layer == NULL) {
+		reminders_layer = panel_text_layer(REMINDERS_PANEL, GRect(6, 0, 132, 45), FONT_KEY_GOTHIC_18_BOLD, GTextAlignmentLeft);
+		carousel_set_enabled(REMINDERS_PANEL, true);
 	}
+	set_text_if_changed(reminders_layer, FIELD_REMINDERS, t);
+}
 
+static void rcv_nav(const Tuple *t) {
+	if (nav_layer == NULL) {
+		nav_layer = panel_text_layer(NAV_PANEL, GRect(6, 0, 132, 45), FONT_KEY_GOTHIC_18_BOLD, GTextAlignmentLeft);
+		carousel_set_enabled(NAV_PANEL, true);
+	}
+	set_text_if_changed(nav_layer, FIELD_NAV, t);
+}
 
-	t=dict_find(received, SM_STATUS_MUS_ARTIST_KEY); 
-	if (t!=NULL) {
-		memcpy(music_artist_str1, t->value->cstring, strlen(t->value->cstring));
+//each chunk is decoded as it arrives, the rows received so far are shown right away
+static void rcv_stream_bitmap(const Tuple *t) {
+	if (!bmp_stream_chunk(t->value->data, t->length))
+		return;
 
-        music_artist_str1[strlen(t->value->cstring)] = '\0';
-		text_layer_set_text(music_artist_layer, music_artist_str1); 	
+	if (stream_image_layer == NULL) {
+		stream_image_layer = bitmap_layer_create(GRect(0, 0, 144, 45));
+		bitmap_layer_set_bitmap(stream_image_layer, bmp_stream_bitmap());
+		layer_add_child(panel_layer[IMAGE_PANEL], bitmap_layer_get_layer(stream_image_layer));
+		carousel_set_enabled(IMAGE_PANEL, true);
 	}
+	render_mark_dirty(bitmap_layer_get_layer(stream_image_layer));
+}
 
-	t=dict_find(received, SM_STATUS_MUS_TITLE_KEY); 
-	if (t!=NULL) {
-		memcpy(music_title_str1, t->value->cstring, strlen(t->value->cstring));
+//the list is parsed here, once; the layer's update proc only replays it
+static void rcv_canvas(const Tuple *t) {
+	if (!canvas_set_list(t->value->data, t->length)) {
+		suppressedUpdates++;
+		return;
+	}
 
-        music_title_str1[strlen(t->value->cstring)] = '\0';
-		text_layer_set_text(music_song_layer, music_title_str1); 	
+	if (canvas_layer == NULL) {
+		canvas_layer = layer_create(GRect(0, 0, 144, 45));
+		layer_set_update_proc(canvas_layer, canvas_update_proc);
+		layer_add_child(panel_layer[CANVAS_PANEL], canvas_layer);
+		carousel_set_enabled(CANVAS_PANEL, true);
 	}
+	render_mark_dirty(canvas_layer);
+}
+
+//title and current price on top, the graph under them with high and low to its right
+static void build_graph_panel(int graph) {
+	int panel = BITCOIN_PANEL + graph;
+	TextLayer **label = graph_label_layer[graph];
 
+	if (graph_layer[graph] != NULL)
+		return;
 
-	t=dict_find(received, SM_STATUS_UPD_WEATHER_KEY); 
-	if (t!=NULL) {
-		int interval = t->value->int32 * 1000;
+	label[GRAPH_TITLE] = panel_text_layer(panel, GRect(6, 0, 84, 16), FONT_KEY_GOTHIC_14_BOLD, GTextAlignmentLeft);
+	label[GRAPH_CURR] = panel_text_layer(panel, GRect(90, 0, 48, 16), FONT_KEY_GOTHIC_14_BOLD, GTextAlignmentRight);
+	label[GRAPH_HIGH] = panel_text_layer(panel, GRect(104, 14, 34, 16), FONT_KEY_GOTHIC_14, GTextAlignmentRight);
+	label[GRAPH_LOW] = panel_text_layer(panel, GRect(104, 29, 34, 16), FONT_KEY_GOTHIC_14, GTextAlignmentRight);
 
-		if (timerUpdateWeather != NULL)
-			app_timer_cancel(timerUpdateWeather);
-		timerUpdateWeather = app_timer_register(interval , updateWeather, NULL);
+	graph_layer[graph] = sparkline_create(GRect(6, 17, 96, 27));
+	layer_add_child(panel_layer[panel], graph_layer[graph]);
+	carousel_set_enabled(panel, true);
+}
+
+static void rcv_graph(const Tuple *t) {
+	int graph = t->key == SM_BITCOIN_GRAPH_KEY ? BITCOIN_GRAPH : STOCKS_GRAPH;
+
+	build_graph_panel(graph);
+	if (!sparkline_append(graph_layer[graph], t->value->data, t->length))
+		suppressedUpdates++;
+}
+
+static void rcv_graph_label(const Tuple *t) {
+	int index = t->key - SM_BITCOIN_LOW_KEY;
+	int graph = index / NUM_GRAPH_LABELS;
+
+	build_graph_panel(graph);
+	set_text_if_changed(graph_label_layer[graph][index % NUM_GRAPH_LABELS], FIELD_BITCOIN_LOW + index, t);
+}
+
+//generations the message brought, checked before any of its tuples is handled
+static void sequence_check(const Tuple *t) {
+	size_t len = t == NULL || t->length < 1 ? 0 : t->length - 1;
+	const uint8_t *gen = t == NULL ? NULL : t->value->data;
+
+	memset(section_seq, SEQ_NEW, sizeof(section_seq));
+	if (len == 0)
+		return;
+	if (len > SM_NUM_SECTIONS)
+		len = SM_NUM_SECTIONS;
+
+	if (gen[0] != s_phone_session) {
+		if (s_phone_session != 0)
+			sequence_stats.restarts++;
+		s_phone_session = gen[0];
+		memset(s_section_gen, 0, sizeof(s_section_gen));
+		snapshot_dirty = true;
+		return;
 	}
 
-	t=dict_find(received, SM_STATUS_UPD_CAL_KEY); 
-	if (t!=NULL) {
-		int interval = t->value->int32 * 1000;
+	for (size_t i = 0; i < len; i++) {
+		uint8_t theirs = gen[1 + i], ours = s_section_gen[i];
+		int8_t ahead = (int8_t)(theirs - ours);
 
-		if (timerUpdateCalendar != NULL)
-			app_timer_cancel(timerUpdateCalendar);
-		timerUpdateCalendar = app_timer_register(interval , updateCalendar, NULL);
+		if (theirs == 0 || ours == 0 || ahead > 0 || ahead < -SEQ_STALE_WINDOW)
+			continue;
+		section_seq[i] = ahead == 0 ? SEQ_DUPLICATE : SEQ_STALE;
 	}
+}
 
-	t=dict_find(received, SM_SONG_LENGTH_KEY); 
-	if (t!=NULL) {
-		int interval = t->value->int32 * 1000;
+//only sections whose tuples came in this message move forward. the phone
+//lists all its generations, taking one for a section it left out would make
+//it skip the next poll of that section.
+static void rcv_section_generations(const Tuple *t, uint8_t handled) {
+	size_t len = t->length < SM_STATUS_GEN_SIZE ? t->length : SM_STATUS_GEN_SIZE;
+	const uint8_t *gen = t->value->data;
+
+	for (size_t i = 0; i + 1 < len; i++) {
+		if (!(handled & (1 << i)) || section_seq[i] != SEQ_NEW || s_section_gen[i] == gen[1 + i])
+			continue;
+		s_section_gen[i] = gen[1 + i];
+		snapshot_dirty = true;
+	}
+}
 
-		if (timerUpdateMusic != NULL)
-			app_timer_cancel(timerUpdateMusic);
-		timerUpdateMusic = app_timer_register(interval , updateMusic, NULL);
+static void rcv_update_weather(const Tuple *t) {
+	refresh_schedule(SM_SECTION_WEATHER, tuple_int(t) * 1000);
+}
 
+static void rcv_update_calendar(const Tuple *t) {
+	refresh_schedule(SM_SECTION_CALENDAR, tuple_int(t) * 1000);
+}
+
+static void rcv_update_music(const Tuple *t) {
+	refresh_schedule(SM_SECTION_MUSIC, tuple_int(t) * 1000);
+}
+
+
+typedef void (*TupleHandler)(const Tuple *t);
+
+//section + 1 of the keys that make up each status section, 0 for the rest
+static const uint8_t rcv_section[SM_NUM_KEYS] = {
+	[SM_WEATHER_COND_KEY - SM_FIRST_KEY]		= SM_SECTION_WEATHER + 1,
+	[SM_WEATHER_TEMP_KEY - SM_FIRST_KEY]		= SM_SECTION_WEATHER + 1,
+	[SM_WEATHER_ICON_KEY - SM_FIRST_KEY]		= SM_SECTION_WEATHER + 1,
+	[SM_COUNT_BATTERY_KEY - SM_FIRST_KEY]		= SM_SECTION_BATTERY + 1,
+	[SM_STATUS_CAL_TIME_KEY - SM_FIRST_KEY]		= SM_SECTION_CALENDAR + 1,
+	[SM_STATUS_CAL_TEXT_KEY - SM_FIRST_KEY]		= SM_SECTION_CALENDAR + 1,
+	[SM_STATUS_MUS_ARTIST_KEY - SM_FIRST_KEY]	= SM_SECTION_MUSIC + 1,
+	[SM_STATUS_MUS_TITLE_KEY - SM_FIRST_KEY]	= SM_SECTION_MUSIC + 1,
+};
+
+//indexed by key - SM_FIRST_KEY, so dispatch is a bounds check and a load
+static const TupleHandler rcv_handlers[SM_NUM_KEYS] = {
+	[SM_WEATHER_COND_KEY - SM_FIRST_KEY]		= rcv_weather_cond,
+	[SM_WEATHER_TEMP_KEY - SM_FIRST_KEY]		= rcv_weather_temp,
+	[SM_WEATHER_ICON_KEY - SM_FIRST_KEY]		= rcv_weather_icon,
+	[SM_COUNT_BATTERY_KEY - SM_FIRST_KEY]		= rcv_battery,
+	[SM_STATUS_CAL_TIME_KEY - SM_FIRST_KEY]		= rcv_calendar_time,
+	[SM_STATUS_CAL_TEXT_KEY - SM_FIRST_KEY]		= rcv_calendar_text,
+	[SM_STATUS_MUS_ARTIST_KEY - SM_FIRST_KEY]	= rcv_music_artist,
+	[SM_STATUS_MUS_TITLE_KEY - SM_FIRST_KEY]	= rcv_music_title,
+	[SM_WEATHER_DAY1_KEY - SM_FIRST_KEY]		= rcv_forecast_day,
+	[SM_WEATHER_DAY2_KEY - SM_FIRST_KEY]		= rcv_forecast_day,
+	[SM_WEATHER_DAY3_KEY - SM_FIRST_KEY]		= rcv_forecast_day,
+	[SM_WEATHER_ICON1_KEY - SM_FIRST_KEY]		= rcv_forecast_icon,
+	[SM_WEATHER_ICON2_KEY - SM_FIRST_KEY]		= rcv_forecast_icon,
+	[SM_WEATHER_ICON3_KEY - SM_FIRST_KEY]		= rcv_forecast_icon,
+	[SM_REMINDERS_KEY - SM_FIRST_KEY]			= rcv_reminders,
+	[SM_NAV_INSTRUCTIONS_KEY - SM_FIRST_KEY]	= rcv_nav,
+	[SM_STREAMING_BMP_KEY - SM_FIRST_KEY]		= rcv_stream_bitmap,
+	[SM_CANVAS_DICT_KEY - SM_FIRST_KEY]			= rcv_canvas,
+	[SM_STOCKS_GRAPH_KEY - SM_FIRST_KEY]		= rcv_graph,
+	[SM_BITCOIN_GRAPH_KEY - SM_FIRST_KEY]		= rcv_graph,
+	[SM_BITCOIN_LOW_KEY - SM_FIRST_KEY]			= rcv_graph_label,
+	[SM_BITCOIN_HIGH_KEY - SM_FIRST_KEY]		= rcv_graph_label,
+	[SM_BITCOIN_CURR_KEY - SM_FIRST_KEY]		= rcv_graph_label,
+	[SM_BITCOIN_TITLE_KEY - SM_FIRST_KEY]		= rcv_graph_label,
+	[SM_STOCKS_LOW_KEY - SM_FIRST_KEY]			= rcv_graph_label,
+	[SM_STOCKS_HIGH_KEY - SM_FIRST_KEY]			= rcv_graph_label,
+	[SM_STOCKS_CURR_KEY - SM_FIRST_KEY]			= rcv_graph_label,
+	[SM_STOCKS_TITLE_KEY - SM_FIRST_KEY]		= rcv_graph_label,
+	[SM_STATUS_UPD_WEATHER_KEY - SM_FIRST_KEY]	= rcv_update_weather,
+	[SM_STATUS_UPD_CAL_KEY - SM_FIRST_KEY]		= rcv_update_calendar,
+	[SM_SONG_LENGTH_KEY - SM_FIRST_KEY]			= rcv_update_music,
+};
+
+
+const SequenceStats *sm_sequence_stats(void) {
+	return &sequence_stats;
+}
+
+void rcv(DictionaryIterator *received, void *context) {
+	uint8_t rejected = 0;		//sections already counted in sequence_stats
+	uint8_t handled = 0;		//sections with tuples in this message
+	Tuple *gen;
+
+	TRACE_INBOUND(received);
+	DEBUG_BEGIN(start);
+	DEBUG_COUNT(messages_in, 1);
+	DEBUG_COUNT(bytes_in, (const uint8_t *)received->end - (const uint8_t *)received->dictionary);
+
+	link_message_received();
+
+	gen = dict_find(received, SM_STATUS_GEN_KEY);
+	sequence_check(gen);
+
+	// Got a message callback, walk the dictionary once and dispatch each tuple
+	for (Tuple *t = dict_read_first(received); t != NULL; t = dict_read_next(received)) {
+		uint32_t index = t->key - SM_FIRST_KEY;
+
+		if (index >= SM_NUM_KEYS || rcv_handlers[index] == NULL)
+			continue;
+
+		if (rcv_section[index] != 0 && section_seq[rcv_section[index] - 1] != SEQ_NEW) {
+			int section = rcv_section[index] - 1;
+			if (!(rejected & (1 << section))) {
+				rejected |= 1 << section;
+				if (section_seq[section] == SEQ_DUPLICATE)
+					sequence_stats.duplicate++;
+				else
+					sequence_stats.stale++;
+			}
+			continue;
+		}
+		if (rcv_section[index] != 0)
+			handled |= 1 << (rcv_section[index] - 1);
+		rcv_handlers[index](t);
 	}
 
+	//after the sections, whatever order the tuples came in
+	if (gen != NULL)
+		rcv_section_generations(gen, handled);
+
+	if (snapshot_dirty)
+		snapshot_save();
+
+	//bursts of messages share frames
+	render_commit();
+
+	DEBUG_END(DEBUG_RCV, start);
+}
+
+void rcv_dropped(AppMessageResult reason, void *context) {
+	APP_LOG(APP_LOG_LEVEL_WARNING, "inbound message dropped: %d", reason);
 }
 
 int main(void) {
-	app_message_open(app_message_inbox_size_maximum(), app_message_outbox_size_maximum() );
+	//replay starts from the connection state the trace was recorded in
+	TRACE_START();
+	TRACE_CONNECTION(bluetooth_connection_service_peek());
+
+	//buffers sized from the message schema in globals.h, but never above what the firmware allows
+	uint32_t inbox_size = SM_INBOX_SIZE, outbox_size = SM_OUTBOX_SIZE;
+	if (inbox_size > app_message_inbox_size_maximum())
+		inbox_size = app_message_inbox_size_maximum();
+	if (outbox_size > app_message_outbox_size_maximum())
+		outbox_size = app_message_outbox_size_maximum();
+	AppMessageResult result = app_message_open(inbox_size, outbox_size);
+	if (result != APP_MSG_OK)
+		APP_LOG(APP_LOG_LEVEL_ERROR, "app_message_open %lu/%lu failed %d",
+		        (unsigned long)inbox_size, (unsigned long)outbox_size, result);
 	app_message_register_inbox_received(rcv);
+	app_message_register_inbox_dropped(rcv_dropped);
+	outbox_init();
 	
   init();
 
 
   app_event_loop();
-  app_message_deregister_callbacks();
 
+  //deinit takes the window off the stack, and its disappear handler queues the
+  //screen exit, so the outbox and the trace have to stay open until after it
   deinit();
 
+  app_message_deregister_callbacks();
+  TRACE_STOP();
+  outbox_deinit();
+
+  return 0;
 }
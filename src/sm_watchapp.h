@@ -0,0 +1,26 @@
+#ifndef _sm_watchapp_h
+#define _sm_watchapp_h
+
+#include <pebble.h>
+
+//starts an outbound message stamped with the next sequence number and the section generations
+AppMessageResult sm_message_out_get(DictionaryIterator **iter_out);
+//the message from sm_message_out_get went out, the next one gets a new number
+void sm_message_out_sent(void);
+
+void sendCommand(int key);
+void sendCommandInt(int key, int param);
+
+//number of inbound fields that matched what was already on screen and were not redrawn
+uint32_t sm_suppressed_updates(void);
+
+//status sections dropped unread because their generation was not newer than ours
+typedef struct {
+	uint32_t duplicate;		//same generation again, a retransmit
+	uint32_t stale;			//an older generation, a reply that arrived late
+	uint32_t restarts;		//new phone sessions, every generation was forgotten
+} SequenceStats;
+
+const SequenceStats *sm_sequence_stats(void);
+
+#endif
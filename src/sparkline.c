@@ -0,0 +1,182 @@
+#include <pebble.h>
+#include "sparkline.h"
+#include "debug_stats.h"
+#include "render.h"
+
+#define RING_MASK		(SPARKLINE_RING - 1)
+
+typedef struct {
+	GBitmap *bitmap;			//created on the first draw, so hidden graphs cost no memory
+	int16_t w, h;
+	uint8_t visible;			//points that fit: w / SPARKLINE_STEP + 1
+	uint8_t level;				//last level, deltas add to it
+	bool clear;					//series restarted, the bitmap holds the old one
+	uint32_t count;				//points since the last reset
+	uint32_t drawn;				//points already in the bitmap
+	uint8_t ring[SPARKLINE_RING];
+} Sparkline;
+
+static SparklineStats stats;
+
+
+static inline int16_t point_x(Sparkline *s, uint32_t i) {
+	return (int16_t)((i * SPARKLINE_STEP) % s->w);
+}
+
+static inline int16_t point_y(Sparkline *s, uint32_t i) {
+	return (int16_t)(s->h - 1 - (s->ring[i & RING_MASK] * (s->h - 1) + 127) / 255);
+}
+
+static inline void plot(Sparkline *s, int16_t x, int16_t y) {
+	uint8_t *row = (uint8_t *)s->bitmap->addr + y * s->bitmap->row_size_bytes;
+
+	if (x >= s->w)
+		x -= s->w;
+	row[x >> 3] |= 1 << (x & 7);
+}
+
+static void clear_column(Sparkline *s, int16_t x) {
+	uint8_t *p = (uint8_t *)s->bitmap->addr + (x >> 3);
+	uint8_t mask = ~(1 << (x & 7));
+
+	for (int16_t y = 0; y < s->h; y++, p += s->bitmap->row_size_bytes)
+		*p &= mask;
+}
+
+//segment from point i - 1 to point i, over the columns that belonged to the oldest one
+static void draw_segment(Sparkline *s, uint32_t i) {
+	int16_t x0 = point_x(s, i - 1), x1 = x0 + SPARKLINE_STEP;
+	int16_t y0 = point_y(s, i - 1), y1 = point_y(s, i);
+	int16_t dx = SPARKLINE_STEP, dy = y1 > y0 ? y0 - y1 : y1 - y0;
+	int16_t sy = y1 > y0 ? 1 : -1;
+	int16_t err = dx + dy;
+
+	for (int16_t x = x0 + 1; x <= x1; x++)
+		clear_column(s, x < s->w ? x : x - s->w);
+
+	//bresenham, x always steps forward
+	for (;;) {
+		plot(s, x0, y0);
+		if (x0 == x1 && y0 == y1)
+			break;
+		int16_t e2 = 2 * err;
+		if (e2 >= dy) {
+			err += dy;
+			x0++;
+		}
+		if (e2 <= dx) {
+			err += dx;
+			y0 += sy;
+		}
+	}
+	stats.segments++;
+}
+
+//brings the bitmap up to the last point, only drawing what was appended since
+static void catch_up(Sparkline *s) {
+	uint32_t first = s->count > s->visible ? s->count - s->visible : 0;
+
+	if (s->clear || s->drawn < first) {
+		memset(s->bitmap->addr, 0, s->bitmap->row_size_bytes * s->h);
+		s->drawn = first;
+		s->clear = false;
+		stats.redraws++;
+	}
+
+	for (; s->drawn < s->count; s->drawn++) {
+		if (s->drawn == 0)
+			plot(s, 0, point_y(s, 0));
+		else
+			draw_segment(s, s->drawn);
+	}
+}
+
+static void sparkline_draw(Layer *me, GContext *ctx) {
+	Sparkline *s = layer_get_data(me);
+	int16_t split;
+
+	if (s->count == 0)
+		return;
+
+	if (s->bitmap == NULL) {
+		s->bitmap = gbitmap_create_blank(GSize(s->w, s->h));
+		if (s->bitmap == NULL)
+			return;
+		s->clear = true;
+	}
+	catch_up(s);
+
+	graphics_context_set_compositing_mode(ctx, GCompOpAssign);
+
+	//until the graph wraps the oldest point is column 0, after that it is
+	//the one right of the newest. a rect wider than the bitmap tiles it, so
+	//starting split columns left of the layer puts the oldest column at 0 and
+	//the wrapped part after it; the layer clips the rest
+	split = s->count < s->visible ? 0 : point_x(s, s->count - 1) + 1;
+	if (split == s->w)
+		split = 0;
+	graphics_draw_bitmap_in_rect(ctx, s->bitmap, GRect(-split, 0, s->w + split, s->h));
+}
+
+static void sparkline_update_proc(Layer *me, GContext *ctx) {
+	DEBUG_BEGIN(start);
+	sparkline_draw(me, ctx);
+	DEBUG_END(DEBUG_DRAW_GRAPH, start);
+}
+
+
+Layer *sparkline_create(GRect frame) {
+	Layer *layer = layer_create_with_data(frame, sizeof(Sparkline));
+	Sparkline *s = layer_get_data(layer);
+
+	memset(s, 0, sizeof(*s));
+	s->w = frame.size.w;
+	s->h = frame.size.h;
+	s->visible = s->w / SPARKLINE_STEP + 1;
+	layer_set_update_proc(layer, sparkline_update_proc);
+	return layer;
+}
+
+void sparkline_destroy(Layer *sparkline) {
+	Sparkline *s = layer_get_data(sparkline);
+
+	if (s->bitmap != NULL)
+		gbitmap_destroy(s->bitmap);
+	layer_destroy(sparkline);
+}
+
+bool sparkline_append(Layer *sparkline, const uint8_t *data, size_t length) {
+	Sparkline *s = layer_get_data(sparkline);
+	size_t pos = 1;
+
+	if (length < 1)
+		return false;
+
+	if (data[0] & SPARKLINE_RESET) {
+		if (length < 2)
+			return false;
+		s->count = 0;
+		s->drawn = 0;
+		s->clear = true;
+		s->level = data[1];
+		s->ring[s->count++ & RING_MASK] = s->level;
+		pos = 2;
+	} else if (s->count == 0 || length == 1) {
+		return false;
+	}
+
+	for (; pos < length; pos++) {
+		int16_t level = s->level + (int8_t)data[pos];
+
+		s->level = level < 0 ? 0 : (level > 255 ? 255 : level);
+		s->ring[s->count++ & RING_MASK] = s->level;
+	}
+
+	stats.points += length - 1;
+	render_mark_dirty(sparkline);
+	return true;
+}
+
+const SparklineStats *sparkline_get_stats(void) {
+	return &stats;
+}
@@ -0,0 +1,35 @@
+#ifndef _sparkline_h
+#define _sparkline_h
+
+#include <pebble.h>
+
+//price graph (stocks, bitcoin). the phone sends the series as bytes:
+//  [flags] [level if SPARKLINE_RESET] [delta]...
+//levels are 0..255 over the graph height (the phone scales them to its low/high),
+//each delta is a signed byte added to the previous level. a packet without
+//SPARKLINE_RESET appends to the series shown.
+//
+//the graph is kept in an off-screen bitmap that is drawn as a ring: a new
+//point only clears and draws its own columns, however long the series runs.
+
+#define SPARKLINE_RESET		0x1
+
+#define SPARKLINE_STEP		3		//pixels between points
+#define SPARKLINE_RING		64		//points kept, at least width / SPARKLINE_STEP + 2
+
+typedef struct {
+	uint32_t points;		//points received
+	uint32_t segments;		//segments drawn into the bitmaps
+	uint32_t redraws;		//whole graph drawn again (new series, bitmap created, too far behind)
+} SparklineStats;
+
+//frame width must be a multiple of SPARKLINE_STEP
+Layer *sparkline_create(GRect frame);
+void sparkline_destroy(Layer *sparkline);
+
+//returns false for a packet that added nothing (empty, or deltas without a series)
+bool sparkline_append(Layer *sparkline, const uint8_t *data, size_t length);
+
+const SparklineStats *sparkline_get_stats(void);
+
+#endif
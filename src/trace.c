@@ -0,0 +1,104 @@
+#include <pebble.h>
+#include "trace.h"
+
+#ifdef SM_TRACE
+
+#define LOG_BYTES	48			//per log line, 96 hex digits
+
+static TraceWriter writer;
+static bool running;
+static time_t start_seconds;
+static uint16_t start_ms;
+
+static uint8_t line[LOG_BYTES];
+static size_t line_length;
+
+
+static void log_flush(void) {
+	static const char digits[] = "0123456789abcdef";
+	char hex[LOG_BYTES * 2 + 1];
+
+	if (line_length == 0)
+		return;
+	for (size_t i = 0; i < line_length; i++) {
+		hex[2 * i] = digits[line[i] >> 4];
+		hex[2 * i + 1] = digits[line[i] & 0xf];
+	}
+	hex[2 * line_length] = '\0';
+	APP_LOG(APP_LOG_LEVEL_DEBUG, "smtrace %s", hex);
+	line_length = 0;
+}
+
+static void write_bytes(const void *data, size_t length) {
+	const uint8_t *p = data;
+
+	if (writer != NULL) {
+		writer(p, length);
+		return;
+	}
+	while (length > 0) {
+		size_t n = LOG_BYTES - line_length < length ? LOG_BYTES - line_length : length;
+		memcpy(&line[line_length], p, n);
+		line_length += n;
+		p += n;
+		length -= n;
+		if (line_length == LOG_BYTES)
+			log_flush();
+	}
+}
+
+static void put_le(uint8_t *out, uint32_t value, int bytes) {
+	for (int i = 0; i < bytes; i++)
+		out[i] = (uint8_t)(value >> (8 * i));
+}
+
+
+void trace_set_writer(TraceWriter w) {
+	writer = w;
+}
+
+void trace_start(void) {
+	uint8_t header[TRACE_HEADER_SIZE];
+
+	time_ms(&start_seconds, &start_ms);
+	memcpy(header, TRACE_MAGIC, 4);
+	put_le(&header[4], (uint32_t)start_seconds, 4);
+	write_bytes(header, sizeof(header));
+	running = true;
+}
+
+void trace_stop(void) {
+	log_flush();
+	running = false;
+}
+
+void trace_record(uint8_t kind, const void *payload, uint16_t length) {
+	uint8_t header[TRACE_RECORD_SIZE];
+	time_t seconds;
+	uint16_t ms;
+
+	if (!running)
+		return;
+
+	time_ms(&seconds, &ms);
+	put_le(&header[0], (uint32_t)(seconds - start_seconds) * 1000 + ms - start_ms, 4);
+	header[4] = kind;
+	put_le(&header[5], length, 2);
+	write_bytes(header, sizeof(header));
+	write_bytes(payload, length);
+	log_flush();
+}
+
+void trace_inbound(const DictionaryIterator *iter) {
+	trace_record(TRACE_IN, iter->dictionary, (const uint8_t *)iter->end - (const uint8_t *)iter->dictionary);
+}
+
+void trace_outbound(uint32_t key, int32_t value) {
+	uint8_t payload[8];
+
+	put_le(&payload[0], key, 4);
+	put_le(&payload[4], (uint32_t)value, 4);
+	trace_record(TRACE_OUT, payload, sizeof(payload));
+}
+
+#endif
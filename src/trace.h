@@ -0,0 +1,57 @@
+#ifndef _trace_h
+#define _trace_h
+
+#include <pebble.h>
+
+//capture of the app's message traffic for bench/replay. only built when
+//SM_TRACE is defined (SM_TRACE=1 pebble build); otherwise the TRACE_* macros
+//are empty.
+//
+//trace: "SMT1", u32 start time (seconds), then records
+//  u32 ms since start, u8 kind, u16 length, payload
+//all little endian. payloads:
+//  TRACE_IN          the received dictionary as is
+//  TRACE_OUT         u32 key, i32 value of a sendCommand* call
+//  TRACE_CONNECTION  u8 connected
+//  TRACE_BUTTON      u8 button id of a single click
+//
+//on the watch the trace goes to the app log as "smtrace <hex>" lines,
+//tools/trace_from_log.py turns `pebble logs` output back into the binary file.
+
+#define TRACE_MAGIC			"SMT1"
+#define TRACE_HEADER_SIZE	8
+#define TRACE_RECORD_SIZE	7
+
+enum {TRACE_IN = 1, TRACE_OUT, TRACE_CONNECTION, TRACE_BUTTON};
+
+#ifdef SM_TRACE
+
+//receives the trace bytes in order; NULL logs them as hex
+typedef void (*TraceWriter)(const uint8_t *data, size_t length);
+
+void trace_set_writer(TraceWriter writer);
+void trace_start(void);
+void trace_stop(void);
+void trace_record(uint8_t kind, const void *payload, uint16_t length);
+void trace_inbound(const DictionaryIterator *iter);
+void trace_outbound(uint32_t key, int32_t value);
+
+#define TRACE_START()					trace_start()
+#define TRACE_STOP()					trace_stop()
+#define TRACE_INBOUND(iter)				trace_inbound(iter)
+#define TRACE_OUTBOUND(key, value)		trace_outbound(key, value)
+#define TRACE_CONNECTION(connected)		do { uint8_t c_ = (connected); trace_record(TRACE_CONNECTION, &c_, 1); } while (0)
+#define TRACE_BUTTON(button)			do { uint8_t b_ = (button); trace_record(TRACE_BUTTON, &b_, 1); } while (0)
+
+#else
+
+#define TRACE_START()					((void)0)
+#define TRACE_STOP()					((void)0)
+#define TRACE_INBOUND(iter)				((void)0)
+#define TRACE_OUTBOUND(key, value)		((void)0)
+#define TRACE_CONNECTION(connected)		((void)0)
+#define TRACE_BUTTON(button)			((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef _weather_atlas_h
+#define _weather_atlas_h
+
+//generated by tools/pack_atlas.py, do not edit
+
+#define WEATHER_ICON_W		40
+#define WEATHER_ICON_H		40
+
+//icons are stacked top to bottom in this order
+typedef enum {
+	WEATHER_ICON_SUN,
+	WEATHER_ICON_RAIN,
+	WEATHER_ICON_CLOUD,
+	WEATHER_ICON_SUN_CLOUD,
+	WEATHER_ICON_FOG,
+	WEATHER_ICON_WIND,
+	WEATHER_ICON_SNOW,
+	WEATHER_ICON_THUNDER,
+	WEATHER_ICON_DISCONNECT,
+	NUM_WEATHER_ICONS
+} WeatherIcon;
+
+#define WEATHER_ICON_RECT(icon)	GRect(0, (icon) * WEATHER_ICON_H, WEATHER_ICON_W, WEATHER_ICON_H)
+
+#endif
@@ -0,0 +1,189 @@
+#!/usr/bin/env python3
+#
+# Packs the weather icons into one vertical strip so the watch loads a single
+# resource and takes each icon as a sub-bitmap of it. Writes
+#
+#   resources/images/weather_atlas.png   the packed icons
+#   src/weather_atlas.h                  icon indices and cell size
+#
+# The icon order is the protocol's: SM_WEATHER_ICON_KEY and the forecast
+# icons SM_WEATHER_ICON1..3_KEY send an index into this list.
+#
+# This is a manual step, the outputs are tracked: run it after adding or
+# changing an icon and commit the result. Runs the same on Python 2 and 3.
+#
+# usage: pack_atlas.py [--check] [project dir]
+#
+# --check writes nothing and exits 1 if the tracked outputs are out of date.
+#
+
+import os
+import struct
+import sys
+import zlib
+
+ICONS = [
+    ('SUN', 'sun.png'),
+    ('RAIN', 'rain.png'),
+    ('CLOUD', 'cloud.png'),
+    ('SUN_CLOUD', 'sun_cloud.png'),
+    ('FOG', 'fog.png'),
+    ('WIND', 'wind.png'),
+    ('SNOW', 'snow.png'),
+    ('THUNDER', 'thunder.png'),
+    ('DISCONNECT', 'disconnect_large.png'),
+]
+
+ATLAS_PNG = os.path.join('resources', 'images', 'weather_atlas.png')
+ATLAS_HEADER = os.path.join('src', 'weather_atlas.h')
+
+PNG_SIGNATURE = b'\x89PNG\r\n\x1a\n'
+
+
+def read_png(path):
+    """Decodes a non-interlaced 8 bit RGBA png into (width, height, rows)."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[:8] != PNG_SIGNATURE:
+        raise ValueError('%s: not a png' % path)
+
+    pos = 8
+    idat = b''
+    while pos < len(data):
+        length, kind = struct.unpack('>I4s', data[pos:pos + 8])
+        body = data[pos + 8:pos + 8 + length]
+        if kind == b'IHDR':
+            width, height, depth, color, _, _, interlace = struct.unpack('>IIBBBBB', body)
+            if depth != 8 or color != 6 or interlace != 0:
+                raise ValueError('%s: only 8 bit RGBA non-interlaced pngs are supported' % path)
+        elif kind == b'IDAT':
+            idat += body
+        pos += 12 + length
+
+    raw = bytearray(zlib.decompress(idat))     # ints on Python 2 as well
+    bpp = 4
+    stride = width * bpp
+    rows = []
+    prev = bytearray(stride)
+    for y in range(height):
+        start = y * (stride + 1)
+        kind = raw[start]
+        line = bytearray(raw[start + 1:start + 1 + stride])
+        for x in range(stride):
+            a = line[x - bpp] if x >= bpp else 0
+            b = prev[x]
+            c = prev[x - bpp] if x >= bpp else 0
+            if kind == 1:
+                line[x] = (line[x] + a) & 0xff
+            elif kind == 2:
+                line[x] = (line[x] + b) & 0xff
+            elif kind == 3:
+                line[x] = (line[x] + ((a + b) >> 1)) & 0xff
+            elif kind == 4:
+                p = a + b - c
+                pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+                pred = a if pa <= pb and pa <= pc else (b if pb <= pc else c)
+                line[x] = (line[x] + pred) & 0xff
+        rows.append(bytes(line))
+        prev = line
+    return width, height, rows
+
+
+def chunk(kind, body):
+    return struct.pack('>I', len(body)) + kind + body + struct.pack('>I', zlib.crc32(kind + body) & 0xffffffff)
+
+
+def png_bytes(width, height, rows):
+    raw = b''.join(b'\x00' + row for row in rows)
+    return (PNG_SIGNATURE +
+            chunk(b'IHDR', struct.pack('>IIBBBBB', width, height, 8, 6, 0, 0, 0)) +
+            chunk(b'IDAT', zlib.compress(raw, 9)) +
+            chunk(b'IEND', b''))
+
+
+def header_text(width, height):
+    lines = [
+        '#ifndef _weather_atlas_h',
+        '#define _weather_atlas_h',
+        '',
+        '//generated by tools/pack_atlas.py, do not edit',
+        '',
+        '#define WEATHER_ICON_W\t\t%d' % width,
+        '#define WEATHER_ICON_H\t\t%d' % height,
+        '',
+        '//icons are stacked top to bottom in this order',
+        'typedef enum {',
+    ]
+    lines += ['\tWEATHER_ICON_%s,' % name for name, _ in ICONS]
+    lines += [
+        '\tNUM_WEATHER_ICONS',
+        '} WeatherIcon;',
+        '',
+        '#define WEATHER_ICON_RECT(icon)\tGRect(0, (icon) * WEATHER_ICON_H, WEATHER_ICON_W, WEATHER_ICON_H)',
+        '',
+        '#endif',
+        '',
+    ]
+    return '\n'.join(lines)
+
+
+def is_current(path, content, mode):
+    try:
+        with open(path, 'r' + mode) as f:
+            return f.read() == content
+    except IOError:
+        return False
+
+
+def write_if_changed(path, content, mode):
+    if is_current(path, content, mode):
+        return False
+    with open(path, 'w' + mode) as f:
+        f.write(content)
+    return True
+
+
+def outputs(root):
+    """The packed png and the header, as (path, content, mode) tuples."""
+    images = os.path.join(root, 'resources', 'images')
+    rows = []
+    size = None
+    for name, filename in ICONS:
+        width, height, icon_rows = read_png(os.path.join(images, filename))
+        if size is None:
+            size = (width, height)
+        elif size != (width, height):
+            raise ValueError('%s is %dx%d, expected %dx%d' % (filename, width, height, size[0], size[1]))
+        rows += icon_rows
+
+    width, height = size
+    return [
+        (os.path.join(root, ATLAS_PNG), png_bytes(width, height * len(ICONS), rows), 'b'),
+        (os.path.join(root, ATLAS_HEADER), header_text(width, height), ''),
+    ]
+
+
+def pack(root):
+    changed = False
+    for path, content, mode in outputs(root):
+        changed |= write_if_changed(path, content, mode)
+    return changed
+
+
+def stale(root):
+    """Tracked outputs that do not match the icons, relative to root."""
+    return [os.path.relpath(path, root) for path, content, mode in outputs(root)
+            if not is_current(path, content, mode)]
+
+
+if __name__ == '__main__':
+    args = sys.argv[1:]
+    check = '--check' in args
+    args = [a for a in args if a != '--check']
+    root = args[0] if args else os.path.join(os.path.dirname(os.path.abspath(__file__)), '..')
+    if check:
+        out_of_date = stale(root)
+        for path in out_of_date:
+            sys.stderr.write('%s is out of date, run tools/pack_atlas.py\n' % path)
+        sys.exit(1 if out_of_date else 0)
+    pack(root)
@@ -0,0 +1,40 @@
+#!/usr/bin/env python3
+#
+# Turns the "smtrace <hex>" lines an SM_TRACE build writes to the app log back
+# into the binary trace bench/smreplay reads (format in src/trace.h).
+#
+# usage: pebble logs | tools/trace_from_log.py out.smt
+#        tools/trace_from_log.py out.smt < saved.log
+#
+
+import re
+import sys
+
+LINE = re.compile(r'smtrace ([0-9a-f]+)\s*$')
+MAGIC = b'SMT1'
+
+
+def convert(lines):
+    data = bytearray()
+    for line in lines:
+        m = LINE.search(line)
+        if not m:
+            continue
+        chunk = bytes.fromhex(m.group(1))
+        # a new recording starts over; keep only the last one in the log
+        if chunk.startswith(MAGIC):
+            data = bytearray()
+        data += chunk
+    return bytes(data)
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 2:
+        sys.stderr.write('usage: trace_from_log.py OUT.smt < log\n')
+        sys.exit(2)
+    trace = convert(sys.stdin)
+    if not trace.startswith(MAGIC):
+        sys.stderr.write('no trace found in the log\n')
+        sys.exit(1)
+    with open(sys.argv[1], 'wb') as f:
+        f.write(trace)